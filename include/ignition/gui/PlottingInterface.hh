@@ -21,6 +21,8 @@
 #include <QString>
 #include <QMap>
 #include <QVariant>
+#include <QPointF>
+#include <QVector>
 #ifdef _MSC_VER
 #pragma warning(push, 0)
 #endif
@@ -41,6 +43,24 @@ namespace ignition
 {
 namespace gui
 {
+/// \brief Reduction of the values of a field before they are plotted
+enum class PlotReduction
+{
+  /// \brief Plot all the values
+  KEEP_ALL,
+
+  /// \brief Plot one value out of N
+  EVERY_NTH,
+
+  /// \brief Plot the first value of each time bucket, then the min and max
+  /// of the other values of the bucket once it's complete
+  MIN_MAX,
+
+  /// \brief Plot the mean of the values of each time bucket once it's
+  /// complete
+  MEAN
+};
+
 class PlotDataPrivate;
 
 /// \brief Plot Data containter to hold value and registered charts
@@ -89,6 +109,145 @@ class IGNITION_GUI_VISIBLE PlotData
   private: std::unique_ptr<PlotDataPrivate> dataPtr;
 };
 
+class PlotSeriesPrivate;
+
+/// \brief Fixed-capacity ring buffer holding the points of a chart series.
+/// The memory grows with the points up to the capacity, and once the series
+/// is full each new point replaces the oldest one.
+/// The points are also summarized in a min/max pyramid, whose coarser levels
+/// keep a longer history than the raw points, so a range of any length can
+/// be drawn with a bounded number of points.
+/// The x coordinates are kept increasing: when an appended x is before the
+/// last one, like after a simulation reset, the following points are offset
+/// to continue from the last point, as the field logs do.
+class IGNITION_GUI_VISIBLE PlotSeries
+{
+  /// \brief Constructor
+  /// \param[in] _capacity Max number of points kept by the series
+  public: explicit PlotSeries(int _capacity = 10000);
+
+  /// \brief Destructor
+  public: ~PlotSeries();
+
+  /// \brief Append a point, dropping the oldest one if the series is full
+  /// \param[in] _point Point to append
+  /// \return The appended point, whose x coordinate is offset if the x
+  /// coordinates went backwards
+  public: QPointF Append(const QPointF &_point);
+
+  /// \brief Number of points in the series
+  /// \return Points count
+  public: int Count() const;
+
+  /// \brief Max number of points kept by the series
+  /// \return Capacity of the series
+  public: int Capacity() const;
+
+  /// \brief Get a point of the series
+  /// \param[in] _index Index of the point, 0 being the oldest point
+  /// \return The point, or (0, 0) if the index is out of range
+  public: QPointF At(int _index) const;
+
+  /// \brief Get all the points of the series
+  /// \return Points ordered from the oldest to the newest
+  public: QVector<QPointF> Points() const;
+
+  /// \brief Get the points to draw a range of the series. The raw points
+  /// are returned if there are few enough of them, otherwise the min and max
+  /// points of each bucket of the finest level which fits in _maxPoints.
+  /// \param[in] _minX Min x coordinate of the range
+  /// \param[in] _maxX Max x coordinate of the range
+  /// \param[in] _maxPoints Max number of returned points, usually twice the
+  /// width of the chart in pixels
+  /// \return Points ordered from the oldest to the newest
+  public: QVector<QPointF> Points(double _minX, double _maxX,
+                                  int _maxPoints) const;
+
+  /// \brief Remove all the points and reset the offset, keeping the
+  /// allocated memory
+  public: void Clear();
+
+  /// \brief Private data member.
+  private: std::unique_ptr<PlotSeriesPrivate> dataPtr;
+};
+
+class PlotHistoryPrivate;
+
+/// \brief Persistent history of a plotted field: an append-only log of
+/// fixed-size (time, value) records, memory-mapped so appending doesn't grow
+/// the heap and reopening the log doesn't copy it.
+/// The records are kept sorted by time across sessions: when the appended
+/// times go backwards, a new segment starts, whose times are offset to
+/// continue from the last record. The header stores the offset of the current
+/// segment, and the ID of the field, which is checked when the log is
+/// opened.
+class IGNITION_GUI_VISIBLE PlotHistory
+{
+  /// \brief Constructor
+  public: PlotHistory();
+
+  /// \brief Destructor
+  public: ~PlotHistory();
+
+  /// \brief Open a log, creating it if it doesn't exist and it's not open
+  /// in read-only mode
+  /// \param[in] _path Path of the log file
+  /// \param[in] _fieldID Field path ID, "topic-field", which must match
+  /// the ID stored in an existing log
+  /// \param[in] _readOnly True to only read the log
+  /// \return True if the log was opened
+  public: bool Open(const std::string &_path, const std::string &_fieldID,
+                    bool _readOnly = false);
+
+  /// \brief Close the log
+  public: void Close();
+
+  /// \brief Check if the log is open
+  /// \return True if open
+  public: bool IsOpen() const;
+
+  /// \brief Append a record to the log, starting a new segment if the
+  /// time is before the last record
+  /// \param[in] _time Time of the record, before the segment offset
+  /// \param[in] _value Value of the record
+  /// \return True if the record was appended
+  public: bool Append(double _time, double _value);
+
+  /// \brief Number of records in the log
+  /// \return Records count
+  public: uint64_t Count() const;
+
+  /// \brief Time offset of the current segment
+  /// \return Offset added to the times of the appended records
+  public: double Offset() const;
+
+  /// \brief Number of segments of the log
+  /// \return Segments count
+  public: uint64_t Segments() const;
+
+  /// \brief Get the records of the log
+  /// \return Records as (time, value) points, from the oldest to the newest
+  public: QVector<QPointF> Points() const;
+
+  /// \brief Get a range of records of the log
+  /// \param[in] _first Index of the first record
+  /// \param[in] _count Max number of records
+  /// \return Records as (time, value) points, from the oldest to the newest
+  public: QVector<QPointF> Points(uint64_t _first, uint64_t _count) const;
+
+  /// \brief Path of the log of a field. The characters of the ID other
+  /// than letters, digits and '_' are percent-escaped, so each field has its
+  /// own file.
+  /// \param[in] _directory Directory of the logs
+  /// \param[in] _fieldID Field path ID, "topic-field"
+  /// \return Path of the log
+  public: static std::string FilePath(const std::string &_directory,
+                                      const std::string &_fieldID);
+
+  /// \brief Private data member.
+  private: std::unique_ptr<PlotHistoryPrivate> dataPtr;
+};
+
 class TopicPrivate;
 
 /// \brief Plotting Topic to handle published topics & their registered fields
@@ -145,10 +304,40 @@ class IGNITION_GUI_VISIBLE Topic : public QObject
   /// \param[in] _y y coordinates of the plot point
   signals: void plot(int _chart, QString _fieldID, double _x, double _y);
 
-  /// \brief update the current time with the default time of the plotting timer
-  /// \param[in] _time current time of the plotting timer
+  /// \brief Notify that a reduction bucket started holding values which
+  /// aren't plotted yet, such as the first value of a MEAN bucket. The
+  /// bucket is plotted by FlushReductions once it expires.
+  signals: void reductionPending();
+
+  /// \brief Set the time used to plot the messages without header. By
+  /// default, these messages are plotted at their reception time on the
+  /// steady clock.
+  /// \param[in] _time Time to plot the messages at, read on each message
   public: void SetPlottingTimeRef(const std::shared_ptr<double> &_time);
 
+  /// \brief Set how the values of a field are reduced before being plotted.
+  /// The fields use MIN_MAX reduction with 1/60 s buckets by default.
+  /// \param[in] _fieldPath model path to the field as an ID
+  /// \param[in] _reduction Reduction of the values
+  /// \param[in] _parameter N for EVERY_NTH, or bucket period in seconds for
+  /// MIN_MAX and MEAN. Ignored for KEEP_ALL.
+  /// \return True if the field is registered and the parameter is valid
+  public: bool SetReduction(const std::string &_fieldPath,
+                            PlotReduction _reduction, double _parameter);
+
+  /// \brief Plot the MIN_MAX and MEAN buckets which didn't receive a value
+  /// for a bucket period, such as the last bucket of a field which stopped
+  /// being published. The buckets are otherwise only completed by the next
+  /// value after them.
+  /// \return Seconds until the earliest bucket still waiting for values
+  /// expires, negative if none is waiting
+  public: double FlushReductions();
+
+  /// \brief Set the directory to log the values of the fields in, see
+  /// PlotHistory. The values aren't logged if the directory is empty.
+  /// \param[in] _directory Directory of the logs
+  public: void SetHistoryDirectory(const std::string &_directory);
+
   /// \brief Private data member.
   private: std::unique_ptr<TopicPrivate> dataPtr;
 };
@@ -178,7 +367,8 @@ class IGNITION_GUI_VISIBLE Transport : public QObject
   /// \param[in] _topic topic name
   /// \param[in] _fieldPath field path ID
   /// \param[in] _chart chart ID
-  /// \param[in] _time ref to current plotting time
+  /// \param[in] _time ref to the time to plot the messages without header,
+  /// null to use their reception time
   public: void Subscribe(const std::string &_topic,
                          const std::string &_fieldPath,
                          int _chart, const std::shared_ptr<double> &_time);
@@ -190,6 +380,27 @@ class IGNITION_GUI_VISIBLE Transport : public QObject
   /// \return Topics list
   public: const std::map<std::string, Topic*> &Topics();
 
+  /// \brief Set the directory to log the values of the subscribed fields in
+  /// \param[in] _directory Directory of the logs, empty to not log them
+  public: void SetHistoryDirectory(const std::string &_directory);
+
+  /// \brief Set how the values of a subscribed field are reduced before
+  /// being plotted, see Topic::SetReduction
+  /// \param[in] _topic topic name
+  /// \param[in] _fieldPath field path ID
+  /// \param[in] _reduction Reduction of the values
+  /// \param[in] _parameter N for EVERY_NTH, or bucket period in seconds
+  /// \return True if the field is subscribed and the parameter is valid
+  public: bool SetReduction(const std::string &_topic,
+                            const std::string &_fieldPath,
+                            PlotReduction _reduction, double _parameter);
+
+  /// \brief Plot the expired reduction buckets of the subscribed topics,
+  /// see Topic::FlushReductions
+  /// \return Seconds until the earliest bucket still waiting for values
+  /// expires, negative if none is waiting
+  public: double FlushReductions();
+
   /// \brief Slot for receiving topics signal at each topic callback to plot
   /// \param[in] _chart chart ID
   /// \param[in] _fieldID field path ID
@@ -204,6 +415,10 @@ class IGNITION_GUI_VISIBLE Transport : public QObject
   /// \param[in] _y y coordinates of the plot point
   signals: void plot(int _chart, QString _fieldID, double _x, double _y);
 
+  /// \brief Notify that a reduction bucket of a subscribed topic holds
+  /// values which aren't plotted yet, see Topic::reductionPending
+  signals: void reductionPending();
+
   /// \brief Private data member.
   private: std::unique_ptr<TransportPrivate> dataPtr;
 };
@@ -240,8 +455,23 @@ class IGNITION_GUI_VISIBLE PlottingInterface : public QObject
                                  QString _fieldPath,
                                  QString _topic);
 
-  /// \brief Get the timeout of updating the plot
-  /// \return updating plot timeout
+  /// \brief called by Qml to set how the values of a subscribed field are
+  /// reduced before being plotted, see Topic::SetReduction
+  /// \param[in] _topic topic name
+  /// \param[in] _fieldPath field path ID
+  /// \param[in] _reduction 0: keep all, 1: every Nth, 2: min/max, 3: mean
+  /// \param[in] _parameter N for every Nth, or bucket period in seconds
+  /// \return True if the field is subscribed and the parameter is valid
+  public slots: bool setReduction(QString _topic, QString _fieldPath,
+                                  int _reduction, double _parameter);
+
+  /// \brief Set the directory to log the values of the plotted fields in.
+  /// The logged values are loaded in the charts plotting these fields again.
+  /// \param[in] _directory Directory of the logs, empty to not log them
+  public: void SetHistoryDirectory(const std::string &_directory);
+
+  /// \brief Get the period of updating the plot
+  /// \return updating plot period in milliseconds
   public: float Timeout() const;
 
   /// \brief slot to get triggered to plot a point and send its data to the UI
@@ -258,6 +488,42 @@ class IGNITION_GUI_VISIBLE PlottingInterface : public QObject
   /// \param[in] _y y coordinates of the plot point
   signals: void plot(int _chart, QString _fieldID, double _x, double _y);
 
+  /// \brief Notify that new points were appended to a chart's series. The
+  /// chart is expected to call refreshChart to draw them.
+  /// \param[in] _chart chart ID
+  /// \param[in] _minX min x coordinate of the new points
+  /// \param[in] _maxX max x coordinate of the new points
+  /// \param[in] _minY min y coordinate of the new points
+  /// \param[in] _maxY max y coordinate of the new points
+  signals: void plotUpdated(int _chart, double _minX, double _maxX,
+                            double _minY, double _maxY);
+
+  /// \brief called by Qml to receive the points of a field in a series
+  /// \param[in] _chart chart ID
+  /// \param[in] _fieldID field path ID
+  /// \param[in] _series QtCharts XY series to draw the points in
+  /// \param[in] _maxPoints max raw points kept in the series history
+  public slots: void registerSeries(int _chart, QString _fieldID,
+                                    QObject *_series, int _maxPoints);
+
+  /// \brief called by Qml to draw the visible range of a chart's series,
+  /// decimated to about 2 points per pixel
+  /// \param[in] _chart chart ID
+  /// \param[in] _minX min x coordinate of the visible range
+  /// \param[in] _maxX max x coordinate of the visible range
+  /// \param[in] _width width of the plot area in pixels
+  public slots: void refreshChart(int _chart, double _minX, double _maxX,
+                                  int _width);
+
+  /// \brief called by Qml to stop receiving the points of a field
+  /// \param[in] _chart chart ID
+  /// \param[in] _fieldID field path ID
+  public slots: void unregisterSeries(int _chart, QString _fieldID);
+
+  /// \brief Deliver the points staged since the last flush to the series,
+  /// one batch per series
+  private slots: void FlushPlots();
+
   /// \brief called by Qml to register a chart to a component attribute
   /// \param[in] _entity entity id which has the component
   /// \param[in] _typeId component type id
@@ -307,28 +573,69 @@ class IGNITION_GUI_VISIBLE PlottingInterface : public QObject
   /// \brief Create suitable file path with unique name and extention
   /// \param[in] _path path selected from the UI
   /// \param[in] _name file name
-  /// \param[in] _extention file extention (csv or pdf)
+  /// \param[in] _extention file extention (csv, pdf, npy or json)
   public slots: std::string FilePath(QString _path, std::string _name,
                                      std::string _extention);
 
-  /// \brief export plot graphs to csv files
+  /// \brief export plot graphs to csv files, one file per series. The
+  /// files are written in the background, notifying the progress with
+  /// exportProgress and exportFinished.
   /// \param[in] _path path of folder to save the csv files
   /// \param[in] _chart plot id to make its name unique
-  /// \param[in] _serieses serieses (graphs) of the plot
-  /// \return True if successfully export, False if any error
+  /// \param[in] _serieses serieses (graphs) of the plot. The stored points
+  /// of the registered serieses are exported, the points in the map are only
+  /// used for the other serieses.
+  /// \return True if the export started, False if any error
   public slots: bool exportCSV(QString _path, int _chart,
                                QMap< QString, QVariant> _serieses);
 
+  /// \brief export plot graphs to a single csv file, with a time column
+  /// and a column per series. The values of the serieses without point at a
+  /// given time are left empty.
+  /// \param[in] _path path of folder to save the csv file
+  /// \param[in] _chart plot id to make its name unique
+  /// \param[in] _serieses serieses (graphs) of the plot, see exportCSV
+  /// \return True if the export started, False if any error
+  public slots: bool exportMergedCSV(QString _path, int _chart,
+                                     QMap< QString, QVariant> _serieses);
+
+  /// \brief export plot graphs to binary NumPy files, one .npy file per
+  /// series holding a (N, 2) float64 array of the time and value of each
+  /// point, and a json file listing the series of each .npy file. The files
+  /// are written in the background, see exportCSV.
+  /// \param[in] _path path of folder to save the files
+  /// \param[in] _chart plot id to make its name unique
+  /// \param[in] _serieses serieses (graphs) of the plot, see exportCSV
+  /// \return True if the export started, False if any error
+  public slots: bool exportNPY(QString _path, int _chart,
+                               QMap< QString, QVariant> _serieses);
+
+  /// \brief Notify the progress of a chart export
+  /// \param[in] _chart plot id
+  /// \param[in] _progress written fraction of the points, from 0 to 1
+  signals: void exportProgress(int _chart, double _progress);
+
+  /// \brief Notify that a chart export is done
+  /// \param[in] _chart plot id
+  /// \param[in] _success True if all the files were written
+  signals: void exportFinished(int _chart, bool _success);
+
   /// \brief Get Component Name based on its type Id
   /// \param[in] _typeId type Id of the component
   /// \return Component name
   signals: std::string ComponentName(uint64_t _typeId);
 
-  /// \brief configration of the timer
-  public: void InitTimer();
-
-  /// \brief update the plotting tool time
-  public slots: void UpdateTime();
+  /// \brief Prepare the export of a chart and queue it for the export
+  /// thread
+  /// \param[in] _path path of folder to save the files
+  /// \param[in] _chart plot id
+  /// \param[in] _serieses serieses (graphs) of the plot
+  /// \param[in] _extension format of the files, csv or npy
+  /// \param[in] _merged True to write a single file for all the serieses
+  /// \return True if the export was queued
+  private: bool QueueExport(const QString &_path, int _chart,
+                            const QMap<QString, QVariant> &_serieses,
+                            const std::string &_extension, bool _merged);
 
   /// \brief Private data member.
   private: std::unique_ptr<PlottingIfacePrivate> dataPtr;
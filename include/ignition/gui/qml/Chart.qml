@@ -40,6 +40,19 @@ Rectangle {
     unregister the chart from the component attribute
   */
   signal componentUnSubscribe(string entity, string typeId, string attribute, real Id);
+  /**
+    register a series to receive the points of a field or component
+  */
+  signal registerSeries(real Id, string seriesId, var series, int maxPoints);
+  /**
+    unregister a series from receiving points
+  */
+  signal unRegisterSeries(real Id, string seriesId);
+  /**
+    request the points of the visible x range of the serieses,
+    decimated to the plot area width in pixels
+  */
+  signal refreshView(real Id, real minX, real maxX, int width);
   /**
     chart is clicked to swap the chart mode
     from small chart to the main chart in multi charts mode
@@ -48,8 +61,10 @@ Rectangle {
   signal clicked(real Id);
 
   /**
-    Points Limitation: max points of each series
-    When points exceed that limit, some points from begining are deleted
+    Points Limitation: max raw points kept by each series
+    When points exceed that limit, the oldest points are only kept as
+    min/max summaries, which are enough to draw long ranges. The summaries
+    span 512 times that limit
   */
   property int maxPoints: 10000
   /**
@@ -62,14 +77,12 @@ Rectangle {
   property bool multiChartsMode: false
 
   /**
-    add point to a field graph
-    _fieldID field key or path
-    _x x coordinate of the point
-    _y y coordinate of the point
+    expand the chart to fit new points appended to its serieses
+    _minX, _maxX, _minY, _maxY bounds of the new points
   */
-  function appendPoint(_fieldID, _x, _y)
+  function updateBounds(_minX, _maxX, _minY, _maxY)
   {
-    chart.appendPoint(_fieldID, _x, _y);
+    chart.updateBounds(_minX, _maxX, _minY, _maxY);
   }
   /**
     set the chart opacity
@@ -454,6 +467,10 @@ Rectangle {
       current index of colors array
     */
     property int indexColor: 0
+    /**
+      True once the chart received its first points
+    */
+    property bool hasPoints: false
 
     /**
       get sereieses
@@ -494,6 +511,10 @@ Rectangle {
       serieses[ID] = newSeries;
 
       chart.indexColor = (chart.indexColor + 1)  % chart.colors.length;
+
+      // points are drawn in the series from c++
+      main.registerSeries(chartID, ID, newSeries, maxPoints);
+      chart.requestRefresh();
     }
 
     /**
@@ -501,6 +522,7 @@ Rectangle {
       ID field path
     */
     function deleteSeries(ID) {
+      main.unRegisterSeries(chartID, ID);
       // remove the points of the series from the chart
       removeSeries(serieses[ID]);
       // remove the series key from the serieses map
@@ -508,49 +530,54 @@ Rectangle {
     }
 
     /**
-      add point to a specific TextField
-      _fieldID field ID or Path
-      _x x of the point
-      _y y of the point
+      expand the chart boundries to fit new points
+      _minX, _maxX, _minY, _maxY bounds of the new points
     */
-    function appendPoint(_fieldID, _x, _y)
+    function updateBounds(_minX, _maxX, _minY, _maxY)
     {
-      if (!chart.serieses[_fieldID])
-        return;
-
-      // if this is the first point (if the chart is empty):
-      // set the min/max according to that point's coordinates
-      // note: count == 2: because chart has 1 series by default to show plotting grid
-      if (chart.count === 2 && chart.serieses[_fieldID].count === 0)
+      // if these are the first points of the chart:
+      // set the min/max according to their coordinates
+      if (!chart.hasPoints)
       {
-        xAxis.min = _x;
-        xAxis.max = _x + 10;
-        chart.serieses[_fieldID].append(_x, _y);
-        return;
+        chart.hasPoints = true;
+        xAxis.min = _minX;
+        xAxis.max = _minX + 10;
       }
 
       // expand the chart boundries if needed
-      if (xAxis.max  < _x)
+      if (xAxis.max  < _maxX)
       {
-        xAxis.max = _x;
+        xAxis.max = _maxX;
         chart.scrollRight(chart.width * 0.0012);
       }
 
-      if (yAxis.max  < _y)
-        yAxis.max = _y ;
-      if (yAxis.min > _y)
-        yAxis.min = _y ;
-      if (xAxis.min > _x)
-        xAxis.min = _x ;
+      if (yAxis.max  < _maxY)
+        yAxis.max = _maxY;
+      if (yAxis.min > _minY)
+        yAxis.min = _minY;
+      if (xAxis.min > _minX)
+        xAxis.min = _minX;
 
-      // add the point
-      chart.serieses[_fieldID].append(_x, _y);
+      chart.updateHoverText();
 
-      // delete the oldest point to limit the points size
-      if (chart.serieses[_fieldID].count > maxPoints)
-          chart.serieses[_fieldID].removePoints(0,1)
+      // draw the new points
+      chart.requestRefresh();
+    }
 
-      chart.updateHoverText();
+    /**
+      draw the visible range of the serieses
+    */
+    function refresh()
+    {
+      main.refreshView(chartID, xAxis.min, xAxis.max, chart.plotArea.width);
+    }
+
+    /**
+      draw the visible range once the pending changes of the view are done
+    */
+    function requestRefresh()
+    {
+      Qt.callLater(chart.refresh);
     }
 
     width: parent.width
@@ -563,6 +590,8 @@ Rectangle {
     backgroundRoundness: 10
     animationOptions: ChartView.NoAnimation
 
+    onPlotAreaChanged: chart.requestRefresh()
+
     theme: (Material.theme == Material.Light) ? ChartView.ChartThemeLight: ChartView.ChartThemeDark
 
     Text {
@@ -696,6 +725,10 @@ Rectangle {
       min: 0
       max: 3
       tickCount: 9
+
+      // scrolling and zooming change the visible range
+      onMinChanged: chart.requestRefresh()
+      onMaxChanged: chart.requestRefresh()
     }
 
     // to just show the plot at begining
@@ -89,6 +89,9 @@ Rectangle
     chartObject.unSubscribe.connect(main.onUnSubscribe);
     chartObject.componentSubscribe.connect(main.onComponentSubscribe);
     chartObject.componentUnSubscribe.connect(main.onComponentUnSubscribe);
+    chartObject.registerSeries.connect(main.onRegisterSeries);
+    chartObject.unRegisterSeries.connect(main.onUnRegisterSeries);
+    chartObject.refreshView.connect(main.onRefreshView);
     chartObject.clicked.connect(main.onClicked);
   }
 
@@ -125,6 +128,18 @@ Rectangle
   {
     PlottingIface.onComponentUnSubscribe(entity, typeId, attribute, Id);
   }
+  function onRegisterSeries(Id, seriesId, series, maxPoints)
+  {
+    PlottingIface.registerSeries(Id, seriesId, series, maxPoints);
+  }
+  function onUnRegisterSeries(Id, seriesId)
+  {
+    PlottingIface.unregisterSeries(Id, seriesId);
+  }
+  function onRefreshView(Id, minX, maxX, width)
+  {
+    PlottingIface.refreshChart(Id, minX, maxX, width);
+  }
 
   /**
   on chart onClicked:
@@ -174,6 +189,7 @@ Rectangle
 
   /**
   plot point to a chart
+  points are staged in c++ and delivered to the serieses once per frame
   _chart: chart id
   _fieldID: field path or id
   _x: x coordinates of the point
@@ -181,12 +197,49 @@ Rectangle
   */
   function handlePlot(_chart, _fieldID, _x, _y)
   {
-    charts[_chart].appendPoint(_fieldID, _x, _y);
+    PlottingIface.onPlot(_chart, _fieldID, _x, _y);
+  }
+
+  /**
+  expand a chart to fit the points appended to its serieses
+  _chart: chart id
+  _minX, _maxX, _minY, _maxY: bounds of the new points
+  */
+  function handlePlotUpdated(_chart, _minX, _maxX, _minY, _maxY)
+  {
+    if (charts[_chart])
+      charts[_chart].updateBounds(_minX, _maxX, _minY, _maxY);
+  }
+
+  /**
+  show the progress of a chart export
+  _chart: chart id
+  _progress: written fraction of the points
+  */
+  function handleExportProgress(_chart, _progress)
+  {
+    exportProgress.visible = true;
+    exportProgress.value = _progress;
+  }
+
+  /**
+  hide the export progress once the export is done
+  _chart: chart id
+  _success: true if all the files were written
+  */
+  function handleExportFinished(_chart, _success)
+  {
+    exportProgress.visible = false;
+    if (!_success)
+      console.warn("Failed to export Plot" + _chart);
   }
 
   Connections {
     target: PlottingIface
     onPlot : handlePlot(_chart, _fieldID, _x, _y);
+    onPlotUpdated : handlePlotUpdated(_chart, _minX, _maxX, _minY, _maxY);
+    onExportProgress : handleExportProgress(_chart, _progress);
+    onExportFinished : handleExportFinished(_chart, _success);
   }
 
 
@@ -347,6 +400,20 @@ Rectangle
     }
   }
 
+  ProgressBar {
+    id: exportProgress
+    visible: false
+    from: 0
+    to: 1
+    width: 100
+    anchors.right: addBtn.left
+    anchors.verticalCenter: addBtn.verticalCenter
+    anchors.margins: 15
+
+    ToolTip.text: "Exporting"
+    ToolTip.visible: hovered
+  }
+
   Component {
     id : exportWindow
     ApplicationWindow {
@@ -415,9 +482,20 @@ Rectangle
 
       /**
       export all selected charts in the export window to that path
+      the points are read and written by c++ in the background
       */
       function exportCSV(path)
       {
+        return exportCharts(path, "CSV");
+      }
+
+      /**
+      export all selected charts in the export window to that path
+      format: "CSV" or "NPY"
+      */
+      function exportCharts(path, format)
+      {
+      var success = true;
       for (var i = 0; i < chartImages.length; i++)
       {
         if (!chartImages[i].isSelected())
@@ -430,27 +508,21 @@ Rectangle
         if (Object.keys(serieses).length === 0)
           continue;
 
-
-        // convert Serieses to Map of {series_name : points list}
-        // slots in cpp accepts QMap<QString, QVariant>
-        // QVariant could be a list instead of series object
-
+        // the stored points of the serieses are exported from c++,
+        // so only send the serieses keys
         var chartSerieses = {};
-        var seriesArray = [];
         Object.keys(serieses).forEach(function(key) {
-
-          seriesArray = []
-
-          // convert Series to QList<QPointF>
-          for (var j =0; j < serieses[key].count; j++)
-            seriesArray.push(serieses[key].at(j));
-
-          // add series
-          chartSerieses[key] = seriesArray;
+          chartSerieses[key] = [];
         });
 
-        return PlottingIface.exportCSV(path, chart_id, chartSerieses);
+        if (format === "NPY")
+          success = PlottingIface.exportNPY(path, chart_id, chartSerieses) && success;
+        else if (mergeCheckBox.checked)
+          success = PlottingIface.exportMergedCSV(path, chart_id, chartSerieses) && success;
+        else
+          success = PlottingIface.exportCSV(path, chart_id, chartSerieses) && success;
       }
+      return success;
       }
 
       /**
@@ -500,7 +572,7 @@ Rectangle
           property string color: Material.primaryColor
 
           displayText: "Export to"
-          model: ["CSV"]
+          model: ["CSV", "NPY"]
 
           background: Rectangle {
             implicitWidth: 120
@@ -516,6 +588,15 @@ Rectangle
             fileDialog.open();
           }
         }
+        CheckBox {
+          id: mergeCheckBox
+          text: "Single file per chart"
+          checkState: Qt.Unchecked
+          visible: exportBtn.currentText == "CSV"
+          anchors.bottom: parent.bottom
+          anchors.right: exportBtn.left
+          anchors.margins: 10
+        }
         Rectangle {
           id: cancelBtn
           color: Material.color(Material.Grey, Material.Shade600);
@@ -547,9 +628,9 @@ Rectangle
         options: FolderDialog.ShowDirsOnly
 
         onAccepted: {
-          if (exportBtn.currentText == "CSV")
+          if (exportBtn.currentText == "CSV" || exportBtn.currentText == "NPY")
           {
-            var success = exportApp.exportCSV(folder);
+            var success = exportApp.exportCharts(folder, exportBtn.currentText);
             if (success)
               exportApp.close();
           }
@@ -15,7 +15,35 @@
  *
 */
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <set>
 #include <sstream>
+#include <thread>
+#include <vector>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtCharts/QXYSeries>
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <ignition/msgs/header.pb.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
 #include <ignition/common/Console.hh>
 #include <ignition/common/StringUtils.hh>
 #include <ignition/transport/Node.hh>
@@ -26,8 +54,31 @@
 #include "ignition/gui/Application.hh"
 
 #define DEFAULT_TIME (INT_MIN)
-// 1/60 Period like the GuiSystem frequency (60Hz)
-#define MAX_PERIOD_DIFF (0.0166666667)
+// Default reduction bucket period, 1/60 like the GuiSystem frequency (60Hz)
+#define DEFAULT_BUCKET_PERIOD (0.0166666667)
+// Period in ms to deliver the staged points to the charts (60Hz)
+#define FLUSH_PERIOD (16)
+// Number of buckets (or points) merged in each bucket of the next level of
+// the series min/max pyramid
+#define PYRAMID_FACTOR (8)
+// Number of levels of the series min/max pyramid, the coarsest one spanning
+// PYRAMID_FACTOR^(PYRAMID_LEVELS-1) times the history of the raw points
+#define PYRAMID_LEVELS (4)
+// Min number of items allocated by a plot ring when it stores its first item,
+// the storage then doubling up to the ring capacity
+#define RING_MIN_STORAGE (64)
+// Size of the stream buffer used to export the plots (1 MiB)
+#define EXPORT_BUFFER_SIZE (1 << 20)
+// Size of the fixed part of the plot history header: magic string, records
+// count, time offset, segments count and field ID length. The field ID
+// follows, padded to a record boundary.
+#define HISTORY_HEADER_SIZE (40)
+// Size of a plot history record: time and value
+#define HISTORY_RECORD_SIZE (16)
+// Records allocated when a plot history is created, then doubled when full
+#define HISTORY_INITIAL_RECORDS (4096)
+// Records loaded at once from a plot history, then appended by a flush
+#define HISTORY_LOAD_CHUNK (65536)
 
 namespace ignition
 {
@@ -46,118 +97,1436 @@ class PlotDataPrivate
 };
 
 
+/// \brief Reduces the values of a field to the points sent to the charts
+class FieldReducer
+{
+  /// \brief Add a value and get the points to plot
+  /// \param[in] _time Time of the value
+  /// \param[in] _value Value of the field
+  /// \param[out] _points Points to plot, appended
+  /// \return True if the current bucket started holding values which
+  /// aren't plotted yet, so it has to be flushed once it expires
+  public: bool Add(double _time, double _value, std::vector<QPointF> &_points)
+  {
+    QPointF point(_time, _value);
+
+    if (this->reduction == PlotReduction::KEEP_ALL)
+    {
+      _points.push_back(point);
+      return false;
+    }
+
+    if (this->reduction == PlotReduction::EVERY_NTH)
+    {
+      if (this->count == 0)
+        _points.push_back(point);
+      this->count = (this->count + 1) % this->step;
+      return false;
+    }
+
+    this->lastAdded = std::chrono::steady_clock::now();
+
+    // complete the bucket, also when the time goes back
+    if (this->count > 0 && (_time >= this->bucketStart + this->period ||
+        _time < this->bucketStart))
+    {
+      this->Flush(_points);
+    }
+
+    if (this->count == 0)
+    {
+      this->bucketStart = _time;
+      this->sumTime = 0;
+      this->sumValue = 0;
+
+      // plot the first value right away, so slow signals aren't delayed
+      if (this->reduction == PlotReduction::MIN_MAX)
+        _points.push_back(point);
+    }
+    else if (this->count == 1)
+    {
+      this->min = point;
+      this->max = point;
+    }
+    else
+    {
+      if (_value < this->min.y())
+        this->min = point;
+      if (_value > this->max.y())
+        this->max = point;
+    }
+
+    this->sumTime += _time;
+    this->sumValue += _value;
+    this->count++;
+
+    // the first value of a MIN_MAX bucket is already plotted
+    return this->count == (this->reduction == PlotReduction::MEAN ? 1 : 2);
+  }
+
+  /// \brief Get the points of the current bucket and start a new one
+  /// \param[out] _points Points to plot, appended
+  public: void Flush(std::vector<QPointF> &_points)
+  {
+    if (this->reduction == PlotReduction::MEAN && this->count > 0)
+    {
+      _points.push_back(QPointF(this->sumTime / this->count,
+                                this->sumValue / this->count));
+    }
+    // min & max of the values after the first one, in time order
+    else if (this->reduction == PlotReduction::MIN_MAX && this->count > 1)
+    {
+      bool minFirst = this->min.x() <= this->max.x();
+      _points.push_back(minFirst ? this->min : this->max);
+      if (this->min != this->max)
+        _points.push_back(minFirst ? this->max : this->min);
+    }
+    this->count = 0;
+  }
+
+  /// \brief Get the points of the current bucket if no value was added for
+  /// a bucket period, so the last bucket of a field which stops being
+  /// published is plotted too
+  /// \param[in] _now Current time on the steady clock
+  /// \param[out] _points Points to plot, appended
+  /// \return Seconds until the current bucket expires, negative if it has
+  /// no points left to plot
+  public: double FlushExpired(
+      const std::chrono::steady_clock::time_point &_now,
+      std::vector<QPointF> &_points)
+  {
+    bool pending =
+        (this->reduction == PlotReduction::MEAN && this->count > 0) ||
+        (this->reduction == PlotReduction::MIN_MAX && this->count > 1);
+    if (!pending)
+      return -1;
+
+    double remaining = this->period -
+        std::chrono::duration<double>(_now - this->lastAdded).count();
+    if (remaining > 0)
+      return remaining;
+
+    this->Flush(_points);
+    return -1;
+  }
+
+  /// \brief Reduction of the values
+  public: PlotReduction reduction = PlotReduction::MIN_MAX;
+
+  /// \brief Bucket period in seconds for MIN_MAX and MEAN
+  public: double period = DEFAULT_BUCKET_PERIOD;
+
+  /// \brief N for EVERY_NTH
+  public: int step = 1;
+
+  /// \brief Number of values since the last plotted one (EVERY_NTH) or in
+  /// the current bucket
+  public: int count = 0;
+
+  /// \brief Time of the first value of the current bucket
+  public: double bucketStart = 0;
+
+  /// \brief Min value of the current bucket, after the first value
+  public: QPointF min;
+
+  /// \brief Max value of the current bucket, after the first value
+  public: QPointF max;
+
+  /// \brief Sum of the times of the current bucket
+  public: double sumTime = 0;
+
+  /// \brief Sum of the values of the current bucket
+  public: double sumValue = 0;
+
+  /// \brief Steady clock time of the last value added to a bucket
+  public: std::chrono::steady_clock::time_point lastAdded;
+};
+
+/// \brief Field path resolved once against a message descriptor, so the
+/// topic callback doesn't have to parse the path and look up each field by
+/// name on every message.
+class FieldAccessor
+{
+  /// \brief Names of the fields along the path, split at registration time
+  public: std::vector<std::string> names;
+
+  /// \brief Descriptors of the fields along the path, the last one being the
+  /// plotted field
+  public: std::vector<const google::protobuf::FieldDescriptor *> fields;
+
+  /// \brief True if the path resolves to a field of the compiled descriptor
+  public: bool valid = false;
+
+  /// \brief Message types the field was reported as unplottable from, so a
+  /// topic whose type alternates warns once per type
+  public: std::set<const google::protobuf::Descriptor *> reported;
+
+  /// \brief Plot data of the field, owned by the topic's fields
+  public: PlotData *plotData = nullptr;
+
+  /// \brief Full path ID of the field sent to the charts, "topic-field"
+  public: QString id;
+
+  /// \brief Log of the field values, null if they aren't logged
+  public: std::unique_ptr<PlotHistory> history;
+
+  /// \brief Reduction of the field values before they are plotted
+  public: FieldReducer reducer;
+};
+
+/// \brief Fixed-capacity ring of items, the oldest item being dropped once
+/// the ring is full. The storage grows with the items up to the capacity, so
+/// short series don't pay for the full history.
+template<typename T>
+class PlotRing
+{
+  /// \brief Set the capacity and remove all items, releasing the storage
+  /// \param[in] _capacity Max number of items
+  public: void Resize(int _capacity)
+  {
+    this->capacity = std::max(_capacity, 1);
+    std::vector<T>().swap(this->items);
+    this->Clear();
+  }
+
+  /// \brief Append an item, overwriting the oldest one if the ring is full
+  /// \param[in] _item Item to append
+  public: void Push(const T &_item)
+  {
+    if (this->count < this->capacity)
+    {
+      // the ring doesn't wrap before it is full, so the items are stored in
+      // order and the storage can be grown geometrically
+      if (this->count == static_cast<int>(this->items.size()))
+      {
+        this->items.resize(std::min(this->capacity,
+            std::max(2 * this->count, RING_MIN_STORAGE)));
+      }
+      this->items[(this->head + this->count) % this->items.size()] = _item;
+      this->count++;
+      return;
+    }
+
+    this->items[this->head] = _item;
+    this->head = (this->head + 1) % this->capacity;
+    this->dropped = true;
+  }
+
+  /// \brief Get an item, 0 being the oldest one
+  /// \param[in] _index Index of the item, must be less than Count()
+  /// \return The item
+  public: const T &At(int _index) const
+  {
+    return this->items[(this->head + _index) % this->items.size()];
+  }
+
+  /// \brief Number of items in the ring
+  /// \return Items count
+  public: int Count() const
+  {
+    return this->count;
+  }
+
+  /// \brief Max number of items
+  /// \return Capacity of the ring
+  public: int Capacity() const
+  {
+    return this->capacity;
+  }
+
+  /// \brief True if items were dropped to make room for new ones
+  /// \return True if the ring doesn't hold the whole history
+  public: bool Dropped() const
+  {
+    return this->dropped;
+  }
+
+  /// \brief Remove all items, keeping the storage
+  public: void Clear()
+  {
+    this->head = 0;
+    this->count = 0;
+    this->dropped = false;
+  }
+
+  /// \brief Storage of the items, grown up to the capacity
+  private: std::vector<T> items;
+
+  /// \brief Max number of items
+  private: int capacity = 1;
+
+  /// \brief Index of the oldest item
+  private: int head = 0;
+
+  /// \brief Number of items in the ring
+  private: int count = 0;
+
+  /// \brief True once the oldest items started to be overwritten
+  private: bool dropped = false;
+};
+
+/// \brief Index of the first item of a ring with a key not less than a value.
+/// The keys must be sorted, which is the case of the plotted time.
+/// \param[in] _ring Ring to search
+/// \param[in] _value Value to compare the keys with
+/// \param[in] _key Function returning the key of an item
+/// \return Index of the item, Count() if there is none
+template<typename T, typename Key>
+int LowerBound(const PlotRing<T> &_ring, double _value, Key _key)
+{
+  int first = 0;
+  int count = _ring.Count();
+  while (count > 0)
+  {
+    int step = count / 2;
+    if (_key(_ring.At(first + step)) < _value)
+    {
+      first += step + 1;
+      count -= step + 1;
+    }
+    else
+      count = step;
+  }
+  return first;
+}
+
+/// \brief Index of the first item of a ring with a key greater than a value.
+/// The keys must be sorted, which is the case of the plotted time.
+/// \param[in] _ring Ring to search
+/// \param[in] _value Value to compare the keys with
+/// \param[in] _key Function returning the key of an item
+/// \return Index of the item, Count() if there is none
+template<typename T, typename Key>
+int UpperBound(const PlotRing<T> &_ring, double _value, Key _key)
+{
+  int first = 0;
+  int count = _ring.Count();
+  while (count > 0)
+  {
+    int step = count / 2;
+    if (!(_value < _key(_ring.At(first + step))))
+    {
+      first += step + 1;
+      count -= step + 1;
+    }
+    else
+      count = step;
+  }
+  return first;
+}
+
+/// \brief Summary of consecutive points of a series: their x range and their
+/// min and max points
+class PlotBucket
+{
+  /// \brief x coordinate of the first point
+  public: double firstX = 0;
+
+  /// \brief x coordinate of the last point
+  public: double lastX = 0;
+
+  /// \brief Point with the min y coordinate
+  public: QPointF min;
+
+  /// \brief Point with the max y coordinate
+  public: QPointF max;
+};
+
+/// \brief Level of the min/max pyramid of a series
+class PlotLevel
+{
+  /// \brief Completed buckets, each one summarizing PYRAMID_FACTOR buckets
+  /// of the previous level (or points for the first level)
+  public: PlotRing<PlotBucket> buckets;
+
+  /// \brief Bucket being filled
+  public: PlotBucket pending;
+
+  /// \brief Number of items merged in the pending bucket
+  public: int pendingCount = 0;
+};
+
+class PlotSeriesPrivate
+{
+  /// \brief Merge a bucket into another
+  /// \param[in, out] _bucket Bucket to merge into
+  /// \param[in] _other Newer bucket to merge
+  /// \param[in] _first True if _bucket is empty and should be overwritten
+  public: static void Merge(PlotBucket &_bucket, const PlotBucket &_other,
+                            bool _first)
+  {
+    if (_first)
+    {
+      _bucket = _other;
+      return;
+    }
+
+    _bucket.lastX = _other.lastX;
+    if (_other.min.y() < _bucket.min.y())
+      _bucket.min = _other.min;
+    if (_other.max.y() > _bucket.max.y())
+      _bucket.max = _other.max;
+  }
+
+  /// \brief Raw points of the series
+  public: PlotRing<QPointF> points;
+
+  /// \brief Min/max pyramid of the points, from the finest level to the
+  /// coarsest one
+  public: std::vector<PlotLevel> levels;
+
+  /// \brief Offset added to the x coordinates of the appended points, so
+  /// they keep increasing when the time goes backwards
+  public: double offset = 0.0;
+
+  /// \brief X coordinate of the last appended point, after the offset
+  public: double lastX = std::numeric_limits<double>::lowest();
+};
+
+/// \brief Header stamp fields resolved once per message type
+class HeaderAccessor
+{
+  /// \brief Message descriptor the fields were resolved against
+  public: const google::protobuf::Descriptor *descriptor = nullptr;
+
+  /// \brief Header field of the message, null if it has no header stamp
+  public: const google::protobuf::FieldDescriptor *header = nullptr;
+
+  /// \brief Stamp field of the header
+  public: const google::protobuf::FieldDescriptor *stamp = nullptr;
+
+  /// \brief Seconds field of the stamp
+  public: const google::protobuf::FieldDescriptor *sec = nullptr;
+
+  /// \brief Nanoseconds field of the stamp
+  public: const google::protobuf::FieldDescriptor *nsec = nullptr;
+
+  /// \brief True if the header is an ignition::msgs::Header, which is read
+  /// without reflection
+  public: bool typed = false;
+};
+
+class PlotHistoryPrivate
+{
+  /// \brief Map the whole file
+  /// \return True if mapped
+  public: bool Map();
+
+  /// \brief Number of records, bounded by the mapped size
+  /// \return Records count
+  public: uint64_t Count() const;
+
+  /// \brief Time offset of the current segment, stored in the header
+  /// \return Offset added to the appended times
+  public: double Offset() const;
+
+  /// \brief Number of segments, stored in the header
+  /// \return Segments count
+  public: uint64_t Segments() const;
+
+  /// \brief Start a segment with a new time offset
+  /// \param[in] _offset Offset added to the appended times
+  public: void StartSegment(double _offset);
+
+  /// \brief Log file
+  public: QFile file;
+
+  /// \brief Mapped file, null if not mapped
+  public: uchar *data = nullptr;
+
+  /// \brief Mapped size
+  public: qint64 size = 0;
+
+  /// \brief Offset of the first record, after the header and the field ID
+  public: qint64 start = HISTORY_HEADER_SIZE;
+
+  /// \brief True if the log is only read
+  public: bool readOnly = true;
+
+  /// \brief Time of the last record, the records being sorted by time
+  public: double lastTime = std::numeric_limits<double>::lowest();
+
+  /// \brief True until a record is appended since the log was opened
+  public: bool firstAppend = true;
+
+  /// \brief Protects the mapping, which is moved when the file grows
+  public: mutable std::mutex mutex;
+};
+
 class TopicPrivate
 {
-  /// \brief Check the plotable types and get data from reflection
-  /// \param[in] _msg Message to get data from
-  /// \param[in] _field Field within the message to get
-  /// \return Plottable value as double, zero if not plottable
-  public: double FieldData(const google::protobuf::Message &_msg,
-                           const google::protobuf::FieldDescriptor *_field);
+  /// \brief Check the plotable types and get data from reflection
+  /// \param[in] _msg Message to get data from
+  /// \param[in] _field Field within the message to get
+  /// \return Plottable value as double, zero if not plottable
+  public: double FieldData(const google::protobuf::Message &_msg,
+                           const google::protobuf::FieldDescriptor *_field);
+
+  /// \brief Get the value of a field by walking its resolved descriptors
+  /// with read-only reflection
+  /// \param[in] _msg Message to get data from
+  /// \param[in] _accessor Accessor compiled for the message's descriptor
+  /// \return Plottable value as double, zero if not plottable
+  public: double FieldData(const google::protobuf::Message &_msg,
+                           const FieldAccessor &_accessor);
+
+  /// \brief Resolve a field path against a message descriptor
+  /// \param[in] _descriptor Descriptor of the topic's message type
+  /// \param[in, out] _accessor Accessor to resolve
+  public: void Compile(const google::protobuf::Descriptor *_descriptor,
+                       FieldAccessor &_accessor);
+
+  /// \brief Get the header time of a message. Must be called with the mutex
+  /// locked.
+  /// \param[in] _msg Message to get the header time from
+  /// \param[out] _headerTime Header stamp in seconds
+  /// \return True if the message has a header
+  public: bool HeaderTime(const google::protobuf::Message &_msg,
+                          double &_headerTime);
+
+  /// \brief Open the log of a field if a history directory is set
+  /// \param[in, out] _accessor Accessor of the field
+  public: void OpenHistory(FieldAccessor &_accessor);
+
+  /// \brief Directory of the fields logs, empty to not log them
+  public: std::string historyDirectory;
+
+  /// \brief Topic name
+  public: std::string name;
+
+  /// \brief Plotting time overriding the steady clock for the messages
+  /// without header, null to use the steady clock
+  public: std::shared_ptr<double> plottingTime;
+
+  /// \brief Points of a field to plot for the current message, kept to
+  /// reuse its memory
+  public: std::vector<QPointF> points;
+
+  /// \brief Plotting fields to update its values
+  public: std::map<std::string, ignition::gui::PlotData*> fields;
+
+  /// \brief Resolved accessors of the registered fields, with the same keys
+  /// as `fields`
+  public: std::map<std::string, FieldAccessor> accessors;
+
+  /// \brief Message descriptor the accessors were resolved against. A
+  /// message of a different type triggers a new resolution.
+  public: const google::protobuf::Descriptor *descriptor = nullptr;
+
+  /// \brief Header fields of the last message type
+  public: HeaderAccessor headerAccessor;
+
+  /// \brief Protects the fields and accessors, which are registered from the
+  /// GUI thread and read from the transport thread
+  public: std::mutex mutex;
+};
+
+class TransportPrivate
+{
+  /// \brief Node for Commincation
+  public: ignition::transport::Node node;
+
+  /// \brief subscribed topics
+  public: std::map<std::string, ignition::gui::Topic*> topics;
+
+  /// \brief Directory of the fields logs, empty to not log them
+  public: std::string historyDirectory;
+};
+
+/// \brief Point waiting to be delivered to a chart series
+class StagedPoint
+{
+  /// \brief Chart ID
+  public: int chart;
+
+  /// \brief Field path ID
+  public: QString fieldID;
+
+  /// \brief Point coordinates
+  public: QPointF point;
+};
+
+/// \brief Bounds of the points appended to a chart by a flush
+class PlotBounds
+{
+  /// \brief Extend the bounds to a point
+  /// \param[in] _point Point
+  public: void Add(const QPointF &_point)
+  {
+    this->minX = std::min(this->minX, _point.x());
+    this->maxX = std::max(this->maxX, _point.x());
+    this->minY = std::min(this->minY, _point.y());
+    this->maxY = std::max(this->maxY, _point.y());
+  }
+
+  /// \brief Min x coordinate
+  public: double minX = std::numeric_limits<double>::max();
+
+  /// \brief Max x coordinate
+  public: double maxX = std::numeric_limits<double>::lowest();
+
+  /// \brief Min y coordinate
+  public: double minY = std::numeric_limits<double>::max();
+
+  /// \brief Max y coordinate
+  public: double maxY = std::numeric_limits<double>::lowest();
+};
+
+/// \brief Chart series registered from QML to receive points
+class SeriesHandle
+{
+  /// \brief Constructor
+  /// \param[in] _maxPoints Max points of the series
+  public: explicit SeriesHandle(int _maxPoints) : points(_maxPoints)
+  {
+  }
+
+  /// \brief Append a point loaded from the field log
+  /// \param[in] _point Point to append
+  /// \param[in, out] _bounds Bounds extended to the appended point
+  public: void AppendLoaded(const QPointF &_point, PlotBounds &_bounds)
+  {
+    _bounds.Add(this->points.Append(_point));
+    if (_point.x() == this->loadedTime)
+    {
+      this->loadedTies++;
+    }
+    else
+    {
+      this->loadedTime = _point.x();
+      this->loadedTies = 1;
+    }
+  }
+
+  /// \brief Append a point received from the transport, unless it was
+  /// loaded from the field log too. The logs are sorted by time, so the
+  /// received points before the last loaded one were loaded, and so were as
+  /// many points at its time as there were loaded.
+  /// \param[in] _point Point to append
+  /// \param[in, out] _bounds Bounds extended to the appended point
+  /// \return True if the point was appended
+  public: bool AppendReceived(const QPointF &_point, PlotBounds &_bounds)
+  {
+    if (_point.x() < this->loadedTime)
+      return false;
+
+    if (_point.x() == this->loadedTime && this->loadedTies > 0)
+    {
+      this->loadedTies--;
+      return false;
+    }
+
+    _bounds.Add(this->points.Append(_point));
+    return true;
+  }
+
+  /// \brief Series object, which is owned by the chart
+  public: QPointer<QtCharts::QXYSeries> series;
+
+  /// \brief Points of the series, the oldest points are dropped first
+  public: PlotSeries points;
+
+  /// \brief ID of the load of the field log in progress, 0 if none
+  public: int loadId = 0;
+
+  /// \brief Points received while the field log is loaded, appended after
+  /// the loaded points to keep the series sorted
+  public: QVector<QPointF> held;
+
+  /// \brief Time of the last point loaded from the field log
+  public: double loadedTime = std::numeric_limits<double>::lowest();
+
+  /// \brief Number of loaded points at the last loaded time which weren't
+  /// received yet
+  public: int loadedTies = 0;
+};
+
+/// \brief Load of the log of a registered series
+class HistoryLoad
+{
+  /// \brief Chart ID
+  public: int chart = -1;
+
+  /// \brief Field path ID
+  public: QString fieldID;
+
+  /// \brief ID of the load, matching the series handle
+  public: int id = 0;
+
+  /// \brief Path of the log
+  public: std::string path;
+};
+
+/// \brief Chunk of a field log, loaded for a registered series
+class LoadedPoints
+{
+  /// \brief Chart ID
+  public: int chart = -1;
+
+  /// \brief Field path ID
+  public: QString fieldID;
+
+  /// \brief ID of the load, matching the series handle
+  public: int id = 0;
+
+  /// \brief Loaded records
+  public: QVector<QPointF> points;
+
+  /// \brief True if this is the last chunk of the log
+  public: bool done = false;
+};
+
+/// \brief File written by an export job
+class ExportFile
+{
+  /// \brief Path of the file
+  public: std::string path;
+
+  /// \brief Format of the file: "csv", "npy" or "json"
+  public: std::string extension = "csv";
+
+  /// \brief Content of the text files (json)
+  public: std::string text;
+
+  /// \brief Names of the columns, after the time column
+  public: std::vector<std::string> names;
+
+  /// \brief Points of each column, with increasing x coordinates
+  public: std::vector<QVector<QPointF>> columns;
+};
+
+/// \brief Export of a chart, written on the export thread
+class ExportJob
+{
+  /// \brief Chart ID
+  public: int chart = -1;
+
+  /// \brief Files to write
+  public: std::vector<ExportFile> files;
+};
+
+class PlottingIfacePrivate
+{
+  /// \brief Queue an export job and start the export thread if needed
+  /// \param[in] _job Job to queue
+  /// \param[in] _iface Interface notified of the progress
+  public: void QueueExport(ExportJob &&_job, PlottingInterface *_iface);
+
+  /// \brief Write the queued export jobs until the queue is empty
+  /// \param[in] _iface Interface notified of the progress
+  public: void RunExports(PlottingInterface *_iface);
+
+  /// \brief Write a CSV file, with a row per time of the columns
+  /// \param[in] _file File to write
+  /// \param[in] _progress Called with the number of points written so far
+  /// \return True if the file was written
+  public: static bool WriteCSV(const ExportFile &_file,
+      const std::function<void(size_t)> &_progress);
+
+  /// \brief Write each column of a file as a NumPy array of shape (N, 2),
+  /// holding the time and the value of each point as float64. Only the first
+  /// column is written, the npy files having a single series.
+  /// \param[in] _file File to write
+  /// \param[in] _progress Called with the number of points written so far
+  /// \return True if the file was written
+  public: static bool WriteNPY(const ExportFile &_file,
+      const std::function<void(size_t)> &_progress);
+
+  /// \brief Write the text of a file
+  /// \param[in] _file File to write
+  /// \return True if the file was written
+  public: static bool WriteText(const ExportFile &_file);
+
+  /// \brief Start the flush timer from any thread, unless a flush is
+  /// already scheduled
+  public: void ScheduleFlush();
+
+  /// \brief Queue the load of a field log and start the load thread if
+  /// needed
+  /// \param[in] _load Load to queue
+  public: void QueueLoad(HistoryLoad &&_load);
+
+  /// \brief Load the queued field logs in chunks until the queue is empty.
+  /// The chunks are appended by the flushes, one chunk per flush, so large
+  /// logs don't freeze the GUI.
+  public: void RunLoads();
+
+  /// \brief Points staged from the transport threads since the last flush.
+  /// Declared before the transport so it outlives its subscriptions.
+  public: std::vector<StagedPoint> staged;
+
+  /// \brief Points being delivered by the flush. Swapped with `staged` so
+  /// both keep their capacity between frames.
+  public: std::vector<StagedPoint> flushing;
+
+  /// \brief Protects the staged points
+  public: std::mutex stagedMutex;
+
+  /// \brief True if a flush is scheduled for the staged points
+  public: std::atomic<bool> flushScheduled{false};
+
+  /// \brief Timer to deliver the staged points once per frame
+  public: QTimer flushTimer;
+
+  /// \brief Timer to flush the earliest reduction bucket once it expires
+  public: QTimer reductionTimer;
+
+  /// \brief Registered series, by chart ID and field path ID
+  public: std::map<int, std::map<QString, SeriesHandle>> serieses;
+
+  /// \brief Responsible for transport messages and topics
+  public: Transport transport;
+
+  /// \brief Directory of the fields logs, empty to not log them
+  public: std::string historyDirectory;
+
+  /// \brief Export jobs waiting for the export thread
+  public: std::deque<ExportJob> exportJobs;
+
+  /// \brief Protects the export jobs and the export thread state
+  public: std::mutex exportMutex;
+
+  /// \brief True while the export thread writes jobs
+  public: bool exportRunning = false;
+
+  /// \brief Thread writing the export jobs, so the GUI doesn't freeze
+  public: std::thread exportThread;
+
+  /// \brief ID of the last field log load
+  public: int lastLoadId = 0;
+
+  /// \brief Field logs waiting for the load thread
+  public: std::deque<HistoryLoad> loadJobs;
+
+  /// \brief Chunks loaded since the last flush
+  public: std::vector<LoadedPoints> loaded;
+
+  /// \brief Protects the loads and the load thread state
+  public: std::mutex loadMutex;
+
+  /// \brief Notified when the loaded chunks are appended, or to stop
+  /// loading
+  public: std::condition_variable loadCv;
+
+  /// \brief True while the load thread reads logs
+  public: bool loadRunning = false;
+
+  /// \brief True to stop loading the logs
+  public: bool stopLoading = false;
+
+  /// \brief Thread reading the field logs
+  public: std::thread loadThread;
+};
+
+}
+}
+
+using namespace ignition;
+
+/// \brief Time to plot the messages without header
+/// \return Seconds on the steady clock since the first call
+static double SteadyClockTime()
+{
+  static const auto epoch = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - epoch).count();
+}
+
+/// \brief Quote and escape a string to write it in a json file
+/// \param[in] _str String to write
+/// \return Json string
+static std::string JsonString(const std::string &_str)
+{
+  std::string json = "\"";
+  for (char c : _str)
+  {
+    if (c == '"' || c == '\\')
+      json += '\\';
+    json += c;
+  }
+  return json + "\"";
+}
+using namespace gui;
+
+//////////////////////////////////////////////////////
+PlotData::PlotData() :
+    dataPtr(std::make_unique<PlotDataPrivate>())
+{
+  this->dataPtr->value = 0;
+}
+
+//////////////////////////////////////////////////////
+PlotData::~PlotData()
+{
+}
+
+//////////////////////////////////////////////////////
+void PlotData::SetValue(const double _value)
+{
+  this->dataPtr->value = _value;
+}
+
+//////////////////////////////////////////////////////
+double PlotData::Value() const
+{
+  return this->dataPtr->value;
+}
+
+//////////////////////////////////////////////////////
+void PlotData::SetTime(const double _time)
+{
+  this->dataPtr->time = _time;
+}
+
+//////////////////////////////////////////////////////
+double PlotData::Time() const
+{
+  return this->dataPtr->time;
+}
+
+//////////////////////////////////////////////////////
+void PlotData::AddChart(int _chart)
+{
+  this->dataPtr->charts.insert(_chart);
+}
+
+//////////////////////////////////////////////////////
+void PlotData::RemoveChart(int _chart)
+{
+  auto chartIt = this->dataPtr->charts.find(_chart);
+  if (chartIt != this->dataPtr->charts.end())
+    this->dataPtr->charts.erase(chartIt);
+}
+
+//////////////////////////////////////////////////////
+int PlotData::ChartCount() const
+{
+  return this->dataPtr->charts.size();
+}
+
+//////////////////////////////////////////////////////
+std::set<int> &PlotData::Charts()
+{
+  return this->dataPtr->charts;
+}
+
+//////////////////////////////////////////////////////
+PlotSeries::PlotSeries(int _capacity) :
+    dataPtr(std::make_unique<PlotSeriesPrivate>())
+{
+  this->dataPtr->points.Resize(_capacity);
+
+  // each level spans PYRAMID_FACTOR times the history of the previous one
+  this->dataPtr->levels.resize(PYRAMID_LEVELS);
+  for (auto &level : this->dataPtr->levels)
+    level.buckets.Resize(_capacity / PYRAMID_FACTOR);
+}
+
+//////////////////////////////////////////////////////
+PlotSeries::~PlotSeries()
+{
+}
+
+//////////////////////////////////////////////////////
+QPointF PlotSeries::Append(const QPointF &_point)
+{
+  // the range queries search the points by x, so a time going backwards,
+  // like a simulation reset, continues from the last point instead
+  auto &offset = this->dataPtr->offset;
+  if (_point.x() + offset < this->dataPtr->lastX)
+    offset = this->dataPtr->lastX - _point.x();
+
+  QPointF point(_point.x() + offset, _point.y());
+  this->dataPtr->lastX = point.x();
+  this->dataPtr->points.Push(point);
+
+  // summarize the point in the pending bucket of the first level, and
+  // cascade each completed bucket to the next level
+  PlotBucket bucket;
+  bucket.firstX = point.x();
+  bucket.lastX = point.x();
+  bucket.min = point;
+  bucket.max = point;
+
+  for (auto &level : this->dataPtr->levels)
+  {
+    PlotSeriesPrivate::Merge(level.pending, bucket, level.pendingCount == 0);
+    if (++level.pendingCount < PYRAMID_FACTOR)
+      break;
+
+    level.buckets.Push(level.pending);
+    bucket = level.pending;
+    level.pendingCount = 0;
+  }
+
+  return point;
+}
+
+//////////////////////////////////////////////////////
+int PlotSeries::Count() const
+{
+  return this->dataPtr->points.Count();
+}
+
+//////////////////////////////////////////////////////
+int PlotSeries::Capacity() const
+{
+  return this->dataPtr->points.Capacity();
+}
+
+//////////////////////////////////////////////////////
+QPointF PlotSeries::At(int _index) const
+{
+  if (_index < 0 || _index >= this->dataPtr->points.Count())
+    return QPointF();
+
+  return this->dataPtr->points.At(_index);
+}
+
+//////////////////////////////////////////////////////
+QVector<QPointF> PlotSeries::Points() const
+{
+  const auto &points = this->dataPtr->points;
+
+  QVector<QPointF> result;
+  result.reserve(points.Count());
+  for (int i = 0; i < points.Count(); ++i)
+    result.append(points.At(i));
+
+  return result;
+}
+
+//////////////////////////////////////////////////////
+QVector<QPointF> PlotSeries::Points(double _minX, double _maxX,
+    int _maxPoints) const
+{
+  QVector<QPointF> result;
+  const auto &points = this->dataPtr->points;
+  if (points.Count() == 0 || _maxPoints <= 0 || _maxX < _minX)
+    return result;
+
+  auto pointX = [](const QPointF &_p) {return _p.x();};
+
+  // raw points, if they still cover the range and are few enough
+  if (!points.Dropped() || points.At(0).x() <= _minX)
+  {
+    // keep one point out of each side so the lines reach the borders
+    int first = std::max(LowerBound(points, _minX, pointX) - 1, 0);
+    int last = std::min(UpperBound(points, _maxX, pointX) + 1,
+        points.Count());
+
+    if (last - first <= _maxPoints)
+    {
+      result.reserve(last - first);
+      for (int i = first; i < last; ++i)
+        result.append(points.At(i));
+      return result;
+    }
+  }
+
+  // otherwise the finest level with at most 2 points (min & max) per bucket
+  int maxBuckets = std::max(_maxPoints / 2, 1);
+  const auto &levels = this->dataPtr->levels;
+  for (size_t l = 0; l < levels.size(); ++l)
+  {
+    const auto &buckets = levels[l].buckets;
+    bool coarsest = (l + 1 == levels.size());
+
+    if (!coarsest && buckets.Dropped() && buckets.At(0).firstX > _minX)
+      continue;
+
+    int first = std::max(LowerBound(buckets, _minX,
+        [](const PlotBucket &_b) {return _b.lastX;}) - 1, 0);
+    int last = std::min(UpperBound(buckets, _maxX,
+        [](const PlotBucket &_b) {return _b.firstX;}) + 1, buckets.Count());
+
+    // the pending buckets of this level and the finer ones hold the newest
+    // points, from the oldest to the newest
+    PlotBucket tail;
+    bool hasTail = false;
+    for (int p = static_cast<int>(l); p >= 0; --p)
+    {
+      if (levels[p].pendingCount == 0)
+        continue;
+      PlotSeriesPrivate::Merge(tail, levels[p].pending, !hasTail);
+      hasTail = true;
+    }
+    if (hasTail && (tail.lastX < _minX || tail.firstX > _maxX))
+      hasTail = false;
+
+    int count = last - first + (hasTail ? 1 : 0);
+    if (count <= 0)
+      return result;
+    if (count > maxBuckets && !coarsest)
+      continue;
+
+    // merge consecutive buckets if there are still too many of them
+    int group = (count + maxBuckets - 1) / maxBuckets;
+    result.reserve(2 * (count / group + 1));
+
+    PlotBucket merged;
+    int merging = 0;
+    int end = first + count;
+    for (int i = first; i < end; ++i)
+    {
+      const auto &bucket = i < last ? buckets.At(i) : tail;
+      PlotSeriesPrivate::Merge(merged, bucket, merging == 0);
+      if (++merging < group && i + 1 < end)
+        continue;
+
+      // min & max in x order
+      const auto &left = merged.min.x() <= merged.max.x() ?
+          merged.min : merged.max;
+      const auto &right = merged.min.x() <= merged.max.x() ?
+          merged.max : merged.min;
+      result.append(left);
+      if (right != left)
+        result.append(right);
+      merging = 0;
+    }
+    return result;
+  }
+
+  return result;
+}
+
+//////////////////////////////////////////////////////
+void PlotSeries::Clear()
+{
+  this->dataPtr->offset = 0.0;
+  this->dataPtr->lastX = std::numeric_limits<double>::lowest();
+  this->dataPtr->points.Clear();
+  for (auto &level : this->dataPtr->levels)
+  {
+    level.buckets.Clear();
+    level.pendingCount = 0;
+  }
+}
+
+//////////////////////////////////////////////////////
+PlotHistory::PlotHistory() :
+    dataPtr(std::make_unique<PlotHistoryPrivate>())
+{
+}
 
-  /// \brief Topic name
-  public: std::string name;
+//////////////////////////////////////////////////////
+PlotHistory::~PlotHistory()
+{
+  this->Close();
+}
 
-  /// \brief Default Plotting time
-  public: std::shared_ptr<double> plottingTime;
+//////////////////////////////////////////////////////
+bool PlotHistory::Open(const std::string &_path, const std::string &_fieldID,
+                       bool _readOnly)
+{
+  this->Close();
 
-  /// \brief Previous header time to limit the frequency of publishing
-  public: double lastHeaderTime = 0;
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
 
-  /// \brief Plotting fields to update its values
-  public: std::map<std::string, ignition::gui::PlotData*> fields;
-};
+  auto &file = this->dataPtr->file;
+  file.setFileName(QString::fromStdString(_path));
+  this->dataPtr->readOnly = _readOnly;
 
-class TransportPrivate
+  if (!file.open(_readOnly ? QIODevice::ReadOnly : QIODevice::ReadWrite))
+  {
+    ignwarn << "Couldn't open plot history [" << _path << "]" << std::endl;
+    return false;
+  }
+
+  // the records follow the field ID, aligned to the record size
+  qint64 idSize = static_cast<qint64>(_fieldID.size());
+  this->dataPtr->start = HISTORY_HEADER_SIZE + (idSize +
+      HISTORY_RECORD_SIZE - 1) / HISTORY_RECORD_SIZE * HISTORY_RECORD_SIZE;
+
+  // new log: allocate the header and the first records
+  bool created = false;
+  if (file.size() < HISTORY_HEADER_SIZE)
+  {
+    if (_readOnly || !file.resize(this->dataPtr->start +
+        HISTORY_INITIAL_RECORDS * HISTORY_RECORD_SIZE))
+    {
+      ignwarn << "Invalid plot history [" << _path << "]" << std::endl;
+      file.close();
+      return false;
+    }
+    created = true;
+  }
+
+  if (!this->dataPtr->Map())
+  {
+    file.close();
+    return false;
+  }
+
+  auto data = this->dataPtr->data;
+  if (created)
+  {
+    uint64_t length = _fieldID.size();
+    std::memcpy(data, "IGNPLOT3", 8);
+    std::memset(data + 8, 0, this->dataPtr->start - 8);
+    std::memcpy(data + 32, &length, sizeof(length));
+    std::memcpy(data + HISTORY_HEADER_SIZE, _fieldID.data(), length);
+  }
+  else
+  {
+    // the log of another field whose file name collides would be corrupted
+    uint64_t length = 0;
+    std::memcpy(&length, data + 32, sizeof(length));
+    bool valid = std::memcmp(data, "IGNPLOT3", 8) == 0;
+    if (valid && (length != _fieldID.size() ||
+        this->dataPtr->size < this->dataPtr->start ||
+        std::memcmp(data + HISTORY_HEADER_SIZE, _fieldID.data(), length) != 0))
+    {
+      ignwarn << "Plot history [" << _path << "] isn't the log of field ["
+              << _fieldID << "]" << std::endl;
+      valid = false;
+    }
+    else if (!valid)
+    {
+      ignwarn << "Invalid plot history [" << _path << "]" << std::endl;
+    }
+
+    if (!valid)
+    {
+      file.close();
+      this->dataPtr->data = nullptr;
+      this->dataPtr->size = 0;
+      return false;
+    }
+  }
+
+  this->dataPtr->lastTime = std::numeric_limits<double>::lowest();
+  this->dataPtr->firstAppend = true;
+  uint64_t count = this->dataPtr->Count();
+  if (count > 0)
+  {
+    std::memcpy(&this->dataPtr->lastTime, this->dataPtr->data +
+        this->dataPtr->start + (count - 1) * HISTORY_RECORD_SIZE,
+        sizeof(double));
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////////
+void PlotHistory::Close()
 {
-  /// \brief Node for Commincation
-  public: ignition::transport::Node node;
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
 
-  /// \brief subscribed topics
-  public: std::map<std::string, ignition::gui::Topic*> topics;
-};
+  // closing the file unmaps it
+  this->dataPtr->file.close();
+  this->dataPtr->data = nullptr;
+  this->dataPtr->size = 0;
+}
 
-class PlottingIfacePrivate
+//////////////////////////////////////////////////////
+bool PlotHistory::IsOpen() const
 {
-  /// \brief Responsible for transport messages and topics
-  public: Transport transport;
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->data != nullptr;
+}
 
-  /// \brief Plotting time pointer to give access to topics to read it
-  public: std::shared_ptr<double> plottingTimeRef = std::make_shared<double>();
+//////////////////////////////////////////////////////
+bool PlotHistory::Append(double _time, double _value)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  if (!this->dataPtr->data || this->dataPtr->readOnly)
+    return false;
 
-  /// \brief timeout to update the plot with the timer
-  public: int timeout;
+  uint64_t count = this->dataPtr->Count();
+  qint64 end = this->dataPtr->start + (count + 1) * HISTORY_RECORD_SIZE;
 
-  /// \brief timer to update the plotting each time step
-  public: QTimer timer;
-};
+  // full: double the file size, which moves the mapping
+  if (end > this->dataPtr->size)
+  {
+    auto &file = this->dataPtr->file;
+    file.unmap(this->dataPtr->data);
+    this->dataPtr->data = nullptr;
+
+    qint64 records =
+        (this->dataPtr->size - this->dataPtr->start) / HISTORY_RECORD_SIZE;
+    qint64 grown = this->dataPtr->start + 2 * records * HISTORY_RECORD_SIZE;
+    if (!file.resize(std::max(end, grown)) || !this->dataPtr->Map())
+    {
+      ignwarn << "Couldn't grow plot history ["
+              << file.fileName().toStdString() << "]" << std::endl;
+      file.close();
+      return false;
+    }
+  }
 
-}
+  // keep the records sorted by time, so the logs can be searched and
+  // replayed. A new session keeps its times if they follow the log, and
+  // times going backwards, like a new session stamped from its start or a
+  // simulation reset, start a segment right after the last record.
+  auto &lastTime = this->dataPtr->lastTime;
+  double offset = this->dataPtr->Offset();
+  if (count == 0)
+  {
+    if (this->dataPtr->Segments() == 0)
+      this->dataPtr->StartSegment(0);
+  }
+  else if (this->dataPtr->firstAppend && _time > lastTime)
+  {
+    if (offset != 0)
+      this->dataPtr->StartSegment(0);
+  }
+  else if (this->dataPtr->firstAppend || _time + offset < lastTime)
+  {
+    offset = std::nextafter(lastTime, std::numeric_limits<double>::max()) -
+        _time;
+    while (_time + offset <= lastTime)
+      offset = std::nextafter(offset, std::numeric_limits<double>::max());
+    this->dataPtr->StartSegment(offset);
+  }
+  this->dataPtr->firstAppend = false;
+
+  // write the record before the count, so readers never see a partial one
+  double record[2] = {_time + this->dataPtr->Offset(), _value};
+  std::memcpy(this->dataPtr->data + end - HISTORY_RECORD_SIZE, record,
+      HISTORY_RECORD_SIZE);
+  ++count;
+  std::memcpy(this->dataPtr->data + 8, &count, sizeof(count));
+  lastTime = record[0];
+
+  return true;
 }
 
-using namespace ignition;
-using namespace gui;
+//////////////////////////////////////////////////////
+uint64_t PlotHistory::Count() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->Count();
+}
 
 //////////////////////////////////////////////////////
-PlotData::PlotData() :
-    dataPtr(std::make_unique<PlotDataPrivate>())
+double PlotHistory::Offset() const
 {
-  this->dataPtr->value = 0;
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->Offset();
 }
 
 //////////////////////////////////////////////////////
-PlotData::~PlotData()
+uint64_t PlotHistory::Segments() const
 {
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->Segments();
 }
 
 //////////////////////////////////////////////////////
-void PlotData::SetValue(const double _value)
+QVector<QPointF> PlotHistory::Points() const
 {
-  this->dataPtr->value = _value;
+  return this->Points(0, std::numeric_limits<uint64_t>::max());
 }
 
 //////////////////////////////////////////////////////
-double PlotData::Value() const
+QVector<QPointF> PlotHistory::Points(uint64_t _first, uint64_t _count) const
 {
-  return this->dataPtr->value;
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+
+  QVector<QPointF> points;
+  uint64_t count = this->dataPtr->Count();
+  if (_first >= count)
+    return points;
+  uint64_t last = _first + std::min(_count, count - _first);
+  points.reserve(last - _first);
+
+  for (uint64_t i = _first; i < last; ++i)
+  {
+    double record[2];
+    std::memcpy(record, this->dataPtr->data + this->dataPtr->start +
+        i * HISTORY_RECORD_SIZE, HISTORY_RECORD_SIZE);
+    points.append(QPointF(record[0], record[1]));
+  }
+  return points;
 }
 
 //////////////////////////////////////////////////////
-void PlotData::SetTime(const double _time)
+std::string PlotHistory::FilePath(const std::string &_directory,
+                                  const std::string &_fieldID)
 {
-  this->dataPtr->time = _time;
+  // percent-escape everything but letters, digits and '_', so different
+  // fields never share a file
+  static const char hex[] = "0123456789ABCDEF";
+  std::string name;
+  name.reserve(_fieldID.size());
+  for (char c : _fieldID)
+  {
+    auto u = static_cast<unsigned char>(c);
+    if (std::isalnum(u) || c == '_')
+    {
+      name += c;
+    }
+    else
+    {
+      name += '%';
+      name += hex[u >> 4];
+      name += hex[u & 0xf];
+    }
+  }
+
+  return _directory + "/" + name + ".plot";
 }
 
 //////////////////////////////////////////////////////
-double PlotData::Time() const
+bool PlotHistoryPrivate::Map()
 {
-  return this->dataPtr->time;
+  this->size = this->file.size();
+  this->data = this->file.map(0, this->size);
+  if (!this->data)
+  {
+    ignwarn << "Couldn't map plot history ["
+            << this->file.fileName().toStdString() << "]" << std::endl;
+    this->size = 0;
+    return false;
+  }
+  return true;
 }
 
 //////////////////////////////////////////////////////
-void PlotData::AddChart(int _chart)
+uint64_t PlotHistoryPrivate::Count() const
 {
-  this->dataPtr->charts.insert(_chart);
+  if (!this->data)
+    return 0;
+
+  uint64_t count;
+  std::memcpy(&count, this->data + 8, sizeof(count));
+
+  // the log may be written by another process after it was mapped
+  if (this->size < this->start)
+    return 0;
+  uint64_t mapped = (this->size - this->start) / HISTORY_RECORD_SIZE;
+  return std::min(count, mapped);
 }
 
 //////////////////////////////////////////////////////
-void PlotData::RemoveChart(int _chart)
+double PlotHistoryPrivate::Offset() const
 {
-  auto chartIt = this->dataPtr->charts.find(_chart);
-  if (chartIt != this->dataPtr->charts.end())
-    this->dataPtr->charts.erase(chartIt);
+  if (!this->data)
+    return 0;
+
+  double offset;
+  std::memcpy(&offset, this->data + 16, sizeof(offset));
+  return offset;
 }
 
 //////////////////////////////////////////////////////
-int PlotData::ChartCount() const
+uint64_t PlotHistoryPrivate::Segments() const
 {
-  return this->dataPtr->charts.size();
+  if (!this->data)
+    return 0;
+
+  uint64_t segments;
+  std::memcpy(&segments, this->data + 24, sizeof(segments));
+  return segments;
 }
 
 //////////////////////////////////////////////////////
-std::set<int> &PlotData::Charts()
+void PlotHistoryPrivate::StartSegment(double _offset)
 {
-  return this->dataPtr->charts;
+  uint64_t segments = this->Segments() + 1;
+  std::memcpy(this->data + 16, &_offset, sizeof(_offset));
+  std::memcpy(this->data + 24, &segments, sizeof(segments));
 }
 
 //////////////////////////////////////////////////////
@@ -183,21 +1552,43 @@ std::string &Topic::Name() const
 //////////////////////////////////////////////////////
 void Topic::Register(const std::string &_fieldPath, int _chart)
 {
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+
   // if a new field create a new field and register the chart
   if (this->dataPtr->fields.count(_fieldPath) == 0)
+  {
     this->dataPtr->fields[_fieldPath] = new PlotData();
 
+    auto &accessor = this->dataPtr->accessors[_fieldPath];
+    accessor.names = ignition::common::Split(_fieldPath, '-');
+    accessor.plotData = this->dataPtr->fields[_fieldPath];
+    accessor.id = QString::fromStdString(this->dataPtr->name + "-" +
+        _fieldPath);
+
+    // resolve it now if the message type is already known, otherwise it's
+    // resolved when the first message arrives
+    if (this->dataPtr->descriptor)
+      this->dataPtr->Compile(this->dataPtr->descriptor, accessor);
+
+    this->dataPtr->OpenHistory(accessor);
+  }
+
   this->dataPtr->fields[_fieldPath]->AddChart(_chart);
 }
 
 //////////////////////////////////////////////////////
 void Topic::UnRegister(const std::string &_fieldPath, int _chart)
 {
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+
   this->dataPtr->fields[_fieldPath]->RemoveChart(_chart);
 
   // if no one registers to the field, remove it
   if (!this->dataPtr->fields[_fieldPath]->ChartCount())
+  {
     this->dataPtr->fields.erase(_fieldPath);
+    this->dataPtr->accessors.erase(_fieldPath);
+  }
 }
 
 //////////////////////////////////////////////////////
@@ -215,134 +1606,190 @@ std::map<std::string, PlotData*> &Topic::Fields()
 //////////////////////////////////////////////////////
 void Topic::Callback(const google::protobuf::Message &_msg)
 {
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+
   // check for header time
   double headerTime;
-  if (!this->HasHeader(_msg, headerTime))
+  if (!this->dataPtr->HeaderTime(_msg, headerTime))
   {
-    if (!this->dataPtr->plottingTime)
-        return;
-
-    headerTime = DEFAULT_TIME;
-
-    if (*this->dataPtr->plottingTime - this->dataPtr->lastHeaderTime
-          < MAX_PERIOD_DIFF)
-      return;
-
-    this->dataPtr->lastHeaderTime = *this->dataPtr->plottingTime;
+    // stamp the messages without header with their reception time
+    headerTime = this->dataPtr->plottingTime ?
+        *this->dataPtr->plottingTime : SteadyClockTime();
   }
-  else
-  {
-    if (headerTime - this->dataPtr->lastHeaderTime < MAX_PERIOD_DIFF)
-        return;
 
-    this->dataPtr->lastHeaderTime = headerTime;
+  // resolve the field paths again if the message type changed
+  auto msgDescriptor = _msg.GetDescriptor();
+  if (msgDescriptor != this->dataPtr->descriptor)
+  {
+    this->dataPtr->descriptor = msgDescriptor;
+    for (auto &accessorIt : this->dataPtr->accessors)
+      this->dataPtr->Compile(msgDescriptor, accessorIt.second);
   }
 
   // loop over the registered fields and update them
-  for (auto fieldIt : this->dataPtr->fields)
+  bool bucketPending = false;
+  for (auto &accessorIt : this->dataPtr->accessors)
   {
-    auto msgDescriptor = _msg.GetDescriptor();
-    auto ref = _msg.GetReflection();
+    auto &accessor = accessorIt.second;
+    if (!accessor.valid || !accessor.plotData)
+      continue;
+
+    double data = this->dataPtr->FieldData(_msg, accessor);
+
+    // Field Arrival Time
+    accessor.plotData->SetTime(headerTime);
+
+    // Field Value
+    accessor.plotData->SetValue(data);
 
-    google::protobuf::Message *valueMsg = nullptr;
+    // plot the logged time, which continues the log if the time went
+    // backwards, so the charts match the logs they load
+    double plotTime = headerTime;
+    if (accessor.history && accessor.history->Append(headerTime, data))
+      plotTime += accessor.history->Offset();
 
-    auto fieldFullPath = ignition::common::Split(fieldIt.first, '-');
-    int pathSize = fieldFullPath.size();
+    // reduce the values of high rate fields before plotting them
+    auto &points = this->dataPtr->points;
+    points.clear();
+    if (accessor.reducer.Add(plotTime, data, points))
+      bucketPending = true;
 
-    // loop until you reach the last field in the path
-    for (int i = 0; i < pathSize-1 ; i++)
+    // Update Field Charts UI
+    for (auto const &chart : accessor.plotData->Charts())
     {
-      std::string fieldName = fieldFullPath[i];
+      for (const auto &point : points)
+        emit plot(chart, accessor.id, point.x(), point.y());
+    }
+  }
 
-      auto field = msgDescriptor->FindFieldByName(fieldName);
+  // the values of a bucket which isn't plotted yet don't stage any point,
+  // so they wouldn't schedule the flush that plots the bucket once expired
+  if (bucketPending)
+    emit reductionPending();
+}
 
-      msgDescriptor = field->message_type();
+//////////////////////////////////////////////////////
+bool Topic::SetReduction(const std::string &_fieldPath,
+                         PlotReduction _reduction, double _parameter)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
 
-      if (valueMsg)
-      {
-        valueMsg = ref->MutableMessage
-                (const_cast<google::protobuf::Message *>(valueMsg), field);
-      }
-      else
-      {
-        valueMsg = ref->MutableMessage
-                (const_cast<google::protobuf::Message *>(&_msg), field);
-      }
+  auto accessorIt = this->dataPtr->accessors.find(_fieldPath);
+  if (accessorIt == this->dataPtr->accessors.end())
+    return false;
 
-      if (valueMsg)
-        ref = valueMsg->GetReflection();
-      else
-      {
-        ignwarn << "Invalid topic msg" << std::endl;
-        return;
-      }
-    }
+  FieldReducer reducer;
+  reducer.reduction = _reduction;
+  if (_reduction == PlotReduction::EVERY_NTH)
+  {
+    if (_parameter < 1)
+      return false;
+    reducer.step = static_cast<int>(_parameter);
+  }
+  else if (_reduction != PlotReduction::KEEP_ALL)
+  {
+    if (_parameter <= 0)
+      return false;
+    reducer.period = _parameter;
+  }
 
-    std::string fieldName = fieldFullPath[pathSize-1];
-    double data;
+  accessorIt->second.reducer = reducer;
+  return true;
+}
 
-    if (valueMsg)
-    {
-      auto field = valueMsg->GetDescriptor()->FindFieldByName(fieldName);
-      data = this->dataPtr->FieldData(*valueMsg, field);
-    }
-    else
-    {
-      auto field = msgDescriptor->FindFieldByName(fieldName);
-      data = this->dataPtr->FieldData(_msg, field);
-    }
+//////////////////////////////////////////////////////
+double Topic::FlushReductions()
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
 
-    if (!fieldIt.second)
+  auto now = std::chrono::steady_clock::now();
+  double next = -1;
+  for (auto &accessorIt : this->dataPtr->accessors)
+  {
+    auto &accessor = accessorIt.second;
+    if (!accessor.valid || !accessor.plotData)
       continue;
 
-    // Field Arrival Time
-    fieldIt.second->SetTime(headerTime);
-
-    // Field Value
-    fieldIt.second->SetValue(data);
+    auto &points = this->dataPtr->points;
+    points.clear();
+    double remaining = accessor.reducer.FlushExpired(now, points);
+    if (remaining >= 0 && (next < 0 || remaining < next))
+      next = remaining;
 
-    // Update Field Charts UI
-    this->UpdateGui(fieldIt.first);
+    for (auto const &chart : accessor.plotData->Charts())
+    {
+      for (const auto &point : points)
+        emit plot(chart, accessor.id, point.x(), point.y());
+    }
   }
+  return next;
 }
 
 //////////////////////////////////////////////////////
 bool Topic::HasHeader(const google::protobuf::Message &_msg,
                       double &_headerTime)
 {
-  auto ref = _msg.GetReflection();
-  auto header = _msg.GetDescriptor()->FindFieldByName("header");
-  auto found = ref->HasField(_msg, header);
-
-  if (!found)
-    return false;
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->HeaderTime(_msg, _headerTime);
+}
 
-  auto stamp = header->message_type()->FindFieldByName("stamp");
+//////////////////////////////////////////////////////
+bool TopicPrivate::HeaderTime(const google::protobuf::Message &_msg,
+                              double &_headerTime)
+{
+  auto &accessor = this->headerAccessor;
 
-  if (!stamp)
-    return false;
+  // resolve the header fields once per message type
+  auto msgDescriptor = _msg.GetDescriptor();
+  if (msgDescriptor != accessor.descriptor)
+  {
+    accessor = HeaderAccessor();
+    accessor.descriptor = msgDescriptor;
 
-  auto headerMsg = ref->MutableMessage
-          (const_cast<google::protobuf::Message *>(&_msg), header);
+    auto messageType = google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE;
+    auto header = msgDescriptor->FindFieldByName("header");
+    if (header && !header->is_repeated() && header->cpp_type() == messageType)
+    {
+      auto stamp = header->message_type()->FindFieldByName("stamp");
+      if (stamp && !stamp->is_repeated() && stamp->cpp_type() == messageType)
+      {
+        accessor.header = header;
+        accessor.stamp = stamp;
+        accessor.sec = stamp->message_type()->FindFieldByName("sec");
+        accessor.nsec = stamp->message_type()->FindFieldByName("nsec");
+        accessor.typed =
+            header->message_type() == msgs::Header::descriptor();
+      }
+    }
+  }
 
-  if (!headerMsg)
+  if (!accessor.header)
     return false;
 
-  ref = headerMsg->GetReflection();
+  auto ref = _msg.GetReflection();
+  if (!ref->HasField(_msg, accessor.header))
+    return false;
 
-  auto stampMsg = ref->MutableMessage
-          (const_cast<google::protobuf::Message *>(headerMsg), stamp);
+  const auto &headerMsg = ref->GetMessage(_msg, accessor.header);
 
-  if (!stampMsg)
-    return false;
+  // generated ignition messages: read the stamp directly
+  if (accessor.typed)
+  {
+    auto header = dynamic_cast<const msgs::Header *>(&headerMsg);
+    if (header)
+    {
+      _headerTime = header->stamp().sec() + header->stamp().nsec() * 1e-9;
+      return true;
+    }
+  }
 
-  auto secField = stamp->message_type()->FindFieldByName("sec");
-  auto nsecField = stamp->message_type()->FindFieldByName("nsec");
+  const auto &stampMsg =
+      headerMsg.GetReflection()->GetMessage(headerMsg, accessor.stamp);
 
-  auto sec = this->dataPtr->FieldData(*stampMsg, secField);
-  auto nsec = this->dataPtr->FieldData(*stampMsg, nsecField);
+  double sec = accessor.sec ? this->FieldData(stampMsg, accessor.sec) : 0;
+  double nsec = accessor.nsec ? this->FieldData(stampMsg, accessor.nsec) : 0;
 
-  _headerTime = sec + nsec * std::pow(10, -9);
+  _headerTime = sec + nsec * 1e-9;
 
   return true;
 }
@@ -350,18 +1797,20 @@ bool Topic::HasHeader(const google::protobuf::Message &_msg,
 //////////////////////////////////////////////////////
 void Topic::UpdateGui(const std::string &_field)
 {
-  auto field = this->dataPtr->fields[_field];
+  auto accessorIt = this->dataPtr->accessors.find(_field);
+  if (accessorIt == this->dataPtr->accessors.end() ||
+      !accessorIt->second.plotData)
+  {
+    return;
+  }
+
+  auto field = accessorIt->second.plotData;
 
   auto x = field->Time();
   auto y = field->Value();
 
-  QString fieldFullPath = QString::fromStdString
-          (this->dataPtr->name + "-" + _field);
-
-  auto charts = field->Charts();
-
-  for (auto const &chart : charts)
-    emit plot(chart, fieldFullPath, x, y);
+  for (auto const &chart : field->Charts())
+    emit plot(chart, accessorIt->second.id, x, y);
 }
 
 //////////////////////////////////////////////////////
@@ -371,6 +1820,44 @@ void Topic::SetPlottingTimeRef(const std::shared_ptr<double> &_timeRef)
     this->dataPtr->plottingTime = _timeRef;
 }
 
+//////////////////////////////////////////////////////
+void Topic::SetHistoryDirectory(const std::string &_directory)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+
+  if (this->dataPtr->historyDirectory == _directory)
+    return;
+  this->dataPtr->historyDirectory = _directory;
+
+  for (auto &accessorIt : this->dataPtr->accessors)
+  {
+    accessorIt.second.history.reset();
+    this->dataPtr->OpenHistory(accessorIt.second);
+  }
+}
+
+//////////////////////////////////////////////////////
+void TopicPrivate::OpenHistory(FieldAccessor &_accessor)
+{
+  if (this->historyDirectory.empty() || _accessor.history)
+    return;
+
+  if (!QDir().mkpath(QString::fromStdString(this->historyDirectory)))
+  {
+    ignwarn << "Couldn't create plot history directory ["
+            << this->historyDirectory << "]" << std::endl;
+    return;
+  }
+
+  auto history = std::make_unique<PlotHistory>();
+  auto fieldID = _accessor.id.toStdString();
+  if (history->Open(PlotHistory::FilePath(this->historyDirectory, fieldID),
+      fieldID))
+  {
+    _accessor.history = std::move(history);
+  }
+}
+
 //////////////////////////////////////////////////////
 double TopicPrivate::FieldData(const google::protobuf::Message &_msg,
                                const google::protobuf::FieldDescriptor *_field)
@@ -400,6 +1887,53 @@ double TopicPrivate::FieldData(const google::protobuf::Message &_msg,
   }
 }
 
+//////////////////////////////////////////////////////
+double TopicPrivate::FieldData(const google::protobuf::Message &_msg,
+                               const FieldAccessor &_accessor)
+{
+  // loop until you reach the message holding the last field in the path
+  const google::protobuf::Message *valueMsg = &_msg;
+  for (size_t i = 0; i + 1 < _accessor.fields.size(); ++i)
+  {
+    valueMsg = &valueMsg->GetReflection()->GetMessage(*valueMsg,
+        _accessor.fields[i]);
+  }
+
+  return this->FieldData(*valueMsg, _accessor.fields.back());
+}
+
+//////////////////////////////////////////////////////
+void TopicPrivate::Compile(const google::protobuf::Descriptor *_descriptor,
+                           FieldAccessor &_accessor)
+{
+  _accessor.fields.clear();
+  _accessor.valid = false;
+
+  auto descriptor = _descriptor;
+  for (size_t i = 0; i < _accessor.names.size(); ++i)
+  {
+    auto field = descriptor ?
+        descriptor->FindFieldByName(_accessor.names[i]) : nullptr;
+
+    if (!field || field->is_repeated())
+    {
+      if (_accessor.reported.insert(_descriptor).second)
+      {
+        ignwarn << "Field [" << _accessor.names[i] << "] can't be plotted "
+                << "from messages of type [" << _descriptor->full_name()
+                << "]" << std::endl;
+      }
+      _accessor.fields.clear();
+      return;
+    }
+
+    _accessor.fields.push_back(field);
+    descriptor = field->message_type();
+  }
+
+  _accessor.valid = !_accessor.fields.empty();
+}
+
 ////////////////////////////////////////////
 Transport::Transport() : dataPtr(std::make_unique<TransportPrivate>())
 {
@@ -442,13 +1976,19 @@ void Transport::Subscribe(const std::string &_topic,
     auto topicHandler = new Topic(_topic);
     this->dataPtr->topics[_topic] = topicHandler;
 
+    topicHandler->SetHistoryDirectory(this->dataPtr->historyDirectory);
     topicHandler->Register(_fieldPath, _chart);
     this->dataPtr->node.Subscribe(_topic, &Topic::Callback, topicHandler);
 
     topicHandler->SetPlottingTimeRef(_time);
 
+    // direct connection, so points are staged from the transport thread
+    // instead of queuing an event per point
     connect(topicHandler, SIGNAL(plot(int, QString, double, double)),
-            this, SLOT(onPlot(int, QString, double, double)));
+            this, SLOT(onPlot(int, QString, double, double)),
+            Qt::DirectConnection);
+    connect(topicHandler, SIGNAL(reductionPending()),
+            this, SIGNAL(reductionPending()), Qt::DirectConnection);
   }
   // already exist topic
   else
@@ -465,6 +2005,39 @@ const std::map<std::string, Topic*> &Transport::Topics()
   return this->dataPtr->topics;
 }
 
+//////////////////////////////////////////////////////
+void Transport::SetHistoryDirectory(const std::string &_directory)
+{
+  this->dataPtr->historyDirectory = _directory;
+  for (auto &topic : this->dataPtr->topics)
+    topic.second->SetHistoryDirectory(_directory);
+}
+
+//////////////////////////////////////////////////////
+double Transport::FlushReductions()
+{
+  double next = -1;
+  for (auto &topic : this->dataPtr->topics)
+  {
+    double remaining = topic.second->FlushReductions();
+    if (remaining >= 0 && (next < 0 || remaining < next))
+      next = remaining;
+  }
+  return next;
+}
+
+//////////////////////////////////////////////////////
+bool Transport::SetReduction(const std::string &_topic,
+                             const std::string &_fieldPath,
+                             PlotReduction _reduction, double _parameter)
+{
+  auto topicIt = this->dataPtr->topics.find(_topic);
+  if (topicIt == this->dataPtr->topics.end())
+    return false;
+
+  return topicIt->second->SetReduction(_fieldPath, _reduction, _parameter);
+}
+
 //////////////////////////////////////////////////////
 void Transport::onPlot(int _chart, QString _fieldID, double _x, double _y)
 {
@@ -496,10 +2069,20 @@ PlottingInterface::PlottingInterface() : QObject(),
 {
   connect(&this->dataPtr->transport,
           SIGNAL(plot(int, QString, double, double)), this,
-          SLOT(onPlot(int, QString, double, double)));
+          SLOT(onPlot(int, QString, double, double)), Qt::DirectConnection);
 
-  this->dataPtr->timeout = 1;
-  this->InitTimer();
+  this->dataPtr->flushTimer.setSingleShot(true);
+  this->dataPtr->flushTimer.setInterval(FLUSH_PERIOD);
+  connect(&this->dataPtr->flushTimer, SIGNAL(timeout()), this,
+          SLOT(FlushPlots()));
+
+  // flush once a new reduction bucket may expire, then at the expiry of
+  // the earliest pending bucket
+  connect(&this->dataPtr->transport, &Transport::reductionPending, this,
+          [this]() {this->dataPtr->ScheduleFlush();}, Qt::DirectConnection);
+  this->dataPtr->reductionTimer.setSingleShot(true);
+  connect(&this->dataPtr->reductionTimer, SIGNAL(timeout()), this,
+          SLOT(FlushPlots()));
 
   App()->Engine()->rootContext()->setContextProperty("PlottingIface", this);
 }
@@ -507,6 +2090,18 @@ PlottingInterface::PlottingInterface() : QObject(),
 //////////////////////////////////////////////////////
 PlottingInterface::~PlottingInterface()
 {
+  // the export thread notifies this interface
+  if (this->dataPtr->exportThread.joinable())
+    this->dataPtr->exportThread.join();
+
+  // the load thread starts the flush timer
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->loadMutex);
+    this->dataPtr->stopLoading = true;
+  }
+  this->dataPtr->loadCv.notify_all();
+  if (this->dataPtr->loadThread.joinable())
+    this->dataPtr->loadThread.join();
 }
 
 //////////////////////////////////////////////////////
@@ -522,7 +2117,30 @@ void PlottingInterface::unsubscribe(int _chart,
 //////////////////////////////////////////////////////
 float PlottingInterface::Timeout() const
 {
-  return this->dataPtr->timer.interval();
+  return this->dataPtr->flushTimer.interval();
+}
+
+//////////////////////////////////////////////////////
+void PlottingInterface::SetHistoryDirectory(const std::string &_directory)
+{
+  this->dataPtr->historyDirectory = _directory;
+  this->dataPtr->transport.SetHistoryDirectory(_directory);
+}
+
+//////////////////////////////////////////////////////
+bool PlottingInterface::setReduction(QString _topic, QString _fieldPath,
+                                     int _reduction, double _parameter)
+{
+  if (_reduction < static_cast<int>(PlotReduction::KEEP_ALL) ||
+      _reduction > static_cast<int>(PlotReduction::MEAN))
+  {
+    ignwarn << "Invalid plot reduction [" << _reduction << "]" << std::endl;
+    return false;
+  }
+
+  return this->dataPtr->transport.SetReduction(_topic.toStdString(),
+      _fieldPath.toStdString(), static_cast<PlotReduction>(_reduction),
+      _parameter);
 }
 
 //////////////////////////////////////////////////////
@@ -563,41 +2181,199 @@ void PlottingInterface::subscribe(int _chart,
 {
   this->dataPtr->transport.Subscribe(_topic.toStdString(),
                                      _fieldPath.toStdString(),
-                                     _chart, this->dataPtr->plottingTimeRef);
-}
-
-////////////////////////////////////////////
-void PlottingInterface::InitTimer()
-{
-  this->dataPtr->timer.setInterval(this->dataPtr->timeout);
-  connect(&this->dataPtr->timer, SIGNAL(timeout()), this, SLOT(UpdateTime()));
-  this->dataPtr->timer.start();
+                                     _chart, nullptr);
 }
 
 //////////////////////////////////////////////////////
 void PlottingInterface::onPlot(int _chart, QString _fieldID,
                                double _x, double _y)
 {
-  // if _x == -1, then the msg has not header time
-  // so update x with the default plotting time that is handled by a timer
+  // points without time are plotted at their reception time
   if (static_cast<int>(_x) == DEFAULT_TIME)
-      _x = *this->dataPtr->plottingTimeRef;
+      _x = SteadyClockTime();
 
-  emit this->plot(_chart, _fieldID, _x, _y);
+  // this can be called from the transport threads, so only stage the point
+  // and let the GUI thread deliver all staged points at once
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->stagedMutex);
+    this->dataPtr->staged.push_back({_chart, _fieldID, QPointF(_x, _y)});
+  }
+
+  this->dataPtr->ScheduleFlush();
+}
+
+//////////////////////////////////////////////////////
+void PlottingInterface::FlushPlots()
+{
+  // clear the flag before taking the points, so points staged from now on
+  // schedule a new flush
+  this->dataPtr->flushScheduled = false;
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->stagedMutex);
+    this->dataPtr->flushing.swap(this->dataPtr->staged);
+  }
+
+  // chunks loaded from the field logs, the load thread reads the next ones
+  // meanwhile
+  std::vector<LoadedPoints> loaded;
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->loadMutex);
+    loaded.swap(this->dataPtr->loaded);
+  }
+  this->dataPtr->loadCv.notify_all();
+
+  // bounds of the points appended to each chart
+  std::map<int, PlotBounds> updates;
+
+  auto findHandle = [this](int _chart, const QString &_fieldID)
+      -> SeriesHandle *
+  {
+    auto chartIt = this->dataPtr->serieses.find(_chart);
+    if (chartIt == this->dataPtr->serieses.end())
+      return nullptr;
+    auto handle = chartIt->second.find(_fieldID);
+    if (handle == chartIt->second.end() || !handle->second.series)
+      return nullptr;
+    return &handle->second;
+  };
+
+  for (const auto &chunk : loaded)
+  {
+    // the series may have been unregistered or registered again
+    auto handle = findHandle(chunk.chart, chunk.fieldID);
+    if (!handle || handle->loadId != chunk.id)
+      continue;
+
+    auto &bounds = updates[chunk.chart];
+    for (const auto &point : chunk.points)
+      handle->AppendLoaded(point, bounds);
+
+    if (!chunk.done)
+      continue;
+
+    // the received points follow the loaded ones
+    handle->loadId = 0;
+    for (const auto &point : handle->held)
+      handle->AppendReceived(point, bounds);
+    handle->held.clear();
+    handle->held.squeeze();
+  }
+
+  for (const auto &staged : this->dataPtr->flushing)
+  {
+    auto handle = findHandle(staged.chart, staged.fieldID);
+    if (!handle)
+      continue;
+
+    auto &bounds = updates[staged.chart];
+    if (handle->loadId != 0)
+      handle->held.append(staged.point);
+    else
+      handle->AppendReceived(staged.point, bounds);
+  }
+  this->dataPtr->flushing.clear();
+
+  // plot the buckets of the fields which stopped being published, and check
+  // them again when the earliest pending one expires
+  double nextExpiry = this->dataPtr->transport.FlushReductions();
+  if (nextExpiry >= 0)
+  {
+    this->dataPtr->reductionTimer.start(
+        static_cast<int>(std::ceil(nextExpiry * 1000)));
+  }
+  else
+  {
+    this->dataPtr->reductionTimer.stop();
+  }
+
+  for (const auto &update : updates)
+  {
+    const auto &bounds = update.second;
+    if (bounds.minX <= bounds.maxX)
+    {
+      emit this->plotUpdated(update.first, bounds.minX, bounds.maxX,
+                             bounds.minY, bounds.maxY);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////
+void PlottingInterface::registerSeries(int _chart, QString _fieldID,
+                                       QObject *_series, int _maxPoints)
+{
+  auto series = qobject_cast<QtCharts::QXYSeries *>(_series);
+  if (!series)
+  {
+    ignwarn << "Series of [" << _fieldID.toStdString() << "] can't be plotted"
+            << std::endl;
+    return;
+  }
+
+  auto &chartSerieses = this->dataPtr->serieses[_chart];
+  chartSerieses.erase(_fieldID);
+
+  auto handle = chartSerieses.emplace(_fieldID, std::max(_maxPoints, 1));
+  handle.first->second.series = series;
+
+  // load the logged values of the field in the background, the flushes
+  // append them
+  if (this->dataPtr->historyDirectory.empty())
+    return;
+
+  auto path = PlotHistory::FilePath(this->dataPtr->historyDirectory,
+      _fieldID.toStdString());
+  if (!QFileInfo::exists(QString::fromStdString(path)))
+    return;
+
+  handle.first->second.loadId = ++this->dataPtr->lastLoadId;
+  this->dataPtr->QueueLoad({_chart, _fieldID, handle.first->second.loadId,
+      path});
+}
+
+//////////////////////////////////////////////////////
+void PlottingInterface::refreshChart(int _chart, double _minX, double _maxX,
+                                     int _width)
+{
+  auto chartIt = this->dataPtr->serieses.find(_chart);
+  if (chartIt == this->dataPtr->serieses.end())
+    return;
+
+  for (auto &handle : chartIt->second)
+  {
+    if (!handle.second.series)
+      continue;
+
+    auto points = handle.second.points.Points(_minX, _maxX,
+        2 * std::max(_width, 1));
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    handle.second.series->replace(points);
+#else
+    handle.second.series->replace(points.toList());
+#endif
+  }
 }
 
 //////////////////////////////////////////////////////
-void PlottingInterface::UpdateTime()
+void PlottingInterface::unregisterSeries(int _chart, QString _fieldID)
 {
-  *this->dataPtr->plottingTimeRef += this->dataPtr->timeout * 0.001;
+  auto chartIt = this->dataPtr->serieses.find(_chart);
+  if (chartIt == this->dataPtr->serieses.end())
+    return;
+
+  chartIt->second.erase(_fieldID);
+  if (chartIt->second.empty())
+    this->dataPtr->serieses.erase(chartIt);
 }
 
 //////////////////////////////////////////////////////
 std::string PlottingInterface::FilePath(QString _path, std::string _name,
                                         std::string _extention)
 {
-  if (_extention != "csv" && _extention != "pdf")
+  if (_extention != "csv" && _extention != "pdf" && _extention != "npy" &&
+      _extention != "json")
+  {
     return "";
+  }
 
   if (_path.toStdString().size() < 8)
   {
@@ -618,10 +2394,44 @@ std::string PlottingInterface::FilePath(QString _path, std::string _name,
 //////////////////////////////////////////////////////
 bool PlottingInterface::exportCSV(QString _path, int _chart,
                                   QMap< QString, QVariant> _serieses)
+{
+  return this->QueueExport(_path, _chart, _serieses, "csv", false);
+}
+
+//////////////////////////////////////////////////////
+bool PlottingInterface::exportMergedCSV(QString _path, int _chart,
+                                        QMap< QString, QVariant> _serieses)
+{
+  return this->QueueExport(_path, _chart, _serieses, "csv", true);
+}
+
+//////////////////////////////////////////////////////
+bool PlottingInterface::exportNPY(QString _path, int _chart,
+                                  QMap< QString, QVariant> _serieses)
+{
+  return this->QueueExport(_path, _chart, _serieses, "npy", false);
+}
+
+//////////////////////////////////////////////////////
+bool PlottingInterface::QueueExport(const QString &_path, int _chart,
+    const QMap<QString, QVariant> &_serieses, const std::string &_extension,
+    bool _merged)
 {
   std::string plotName = "Plot" + std::to_string(_chart);
 
-  std::ofstream file;
+  ExportJob job;
+  job.chart = _chart;
+
+  if (_merged)
+  {
+    auto filePath = this->FilePath(_path, plotName, _extension);
+    if (!filePath.size())
+    {
+        ignwarn << "[Couldn't parse file: " << filePath << "]" << std::endl;
+        return false;
+    }
+    job.files.push_back({filePath, _extension, "", {}, {}});
+  }
 
   QMap<QString, QVariant>::const_iterator series = _serieses.constBegin();
   while (series != _serieses.constEnd())
@@ -649,31 +2459,367 @@ bool PlottingInterface::exportCSV(QString _path, int _chart,
     else
       std::replace(key.begin(), key.end(), '-', '/');
 
-    auto name = plotName +  "_" + key;
+    if (!_merged)
+    {
+      auto name = plotName +  "_" + key;
+
+      auto filePath = this->FilePath(_path , name, _extension);
+
+      if (!filePath.size())
+      {
+          ignwarn << "[Couldn't parse file: " << filePath << "]" << std::endl;
+          return false;
+      }
+      job.files.push_back({filePath, _extension, "", {}, {}});
+    }
+
+    // the chart only draws a decimated view of the series, so write the
+    // stored points when the series is registered
+    QVector<QPointF> points;
+    auto chartIt = this->dataPtr->serieses.find(_chart);
+    if (chartIt != this->dataPtr->serieses.end() &&
+        chartIt->second.find(series.key()) != chartIt->second.end())
+    {
+      points = chartIt->second.find(series.key())->second.points.Points();
+    }
+    else
+    {
+      for (const auto &point : series.value().toList())
+        points.append(point.toPointF());
+    }
 
-    auto filePath = this->FilePath(_path , name, "csv");
+    job.files.back().names.push_back(key);
+    job.files.back().columns.push_back(points);
+    ++series;
+  }
 
+  // describe the npy files in a json sidecar, to load them with their names
+  if (_extension == "npy")
+  {
+    auto filePath = this->FilePath(_path, plotName, "json");
     if (!filePath.size())
     {
         ignwarn << "[Couldn't parse file: " << filePath << "]" << std::endl;
         return false;
     }
 
-    file.open(filePath);
-    if (!file.is_open())
-        ignwarn << "[Couldn't open file: " << filePath << "]" << std::endl;
+    std::ostringstream json;
+    json << "{\n  \"chart\": " << _chart << ",\n  \"series\": [";
+    for (size_t i = 0; i < job.files.size(); ++i)
+    {
+      const auto &file = job.files[i];
+      auto fileName = file.path.substr(file.path.rfind('/') + 1);
+      json << (i ? "," : "") << "\n    {"
+           << "\"name\": " << JsonString(file.names.front()) << ", "
+           << "\"file\": " << JsonString(fileName) << ", "
+           << "\"columns\": [\"time\", \"value\"], "
+           << "\"count\": " << file.columns.front().size() << "}";
+    }
+    json << "\n  ]\n}\n";
+
+    job.files.push_back({filePath, "json", json.str(), {}, {}});
+  }
+
+  this->dataPtr->QueueExport(std::move(job), this);
+  return true;
+}
+
+//////////////////////////////////////////////////////
+void PlottingIfacePrivate::ScheduleFlush()
+{
+  if (!this->flushScheduled.exchange(true))
+  {
+    QMetaObject::invokeMethod(&this->flushTimer, "start",
+        Qt::QueuedConnection);
+  }
+}
+
+//////////////////////////////////////////////////////
+void PlottingIfacePrivate::QueueLoad(HistoryLoad &&_load)
+{
+  std::lock_guard<std::mutex> lock(this->loadMutex);
+  this->loadJobs.push_back(std::move(_load));
+
+  if (this->loadRunning)
+    return;
+
+  // the previous thread is done with the queue
+  if (this->loadThread.joinable())
+    this->loadThread.join();
 
-    file << "time, " << key << std::endl;
+  this->loadRunning = true;
+  this->loadThread = std::thread(&PlottingIfacePrivate::RunLoads, this);
+}
 
-    auto points = series.value().toList();
-    for (int j = 0 ; j < points.size(); j++)
+//////////////////////////////////////////////////////
+void PlottingIfacePrivate::RunLoads()
+{
+  while (true)
+  {
+    HistoryLoad load;
     {
-        auto point = points.at(j).toPointF();
-        file << point.x() << ", " << point.y() << std::endl;
+      std::lock_guard<std::mutex> lock(this->loadMutex);
+      if (this->loadJobs.empty() || this->stopLoading)
+      {
+        this->loadRunning = false;
+        return;
+      }
+      load = std::move(this->loadJobs.front());
+      this->loadJobs.pop_front();
     }
 
-    file.close();
-    ++series;
+    // only load the records logged so far, the next ones are received
+    PlotHistory history;
+    uint64_t count = 0;
+    if (history.Open(load.path, load.fieldID.toStdString(), true))
+      count = history.Count();
+
+    uint64_t first = 0;
+    do
+    {
+      LoadedPoints chunk;
+      chunk.chart = load.chart;
+      chunk.fieldID = load.fieldID;
+      chunk.id = load.id;
+      chunk.points = history.Points(first,
+          std::min<uint64_t>(HISTORY_LOAD_CHUNK, count - first));
+      first += HISTORY_LOAD_CHUNK;
+      chunk.done = first >= count;
+
+      // wait for the previous chunks to be appended, so the loaded points
+      // don't pile up in memory
+      {
+        std::unique_lock<std::mutex> lock(this->loadMutex);
+        this->loadCv.wait(lock, [this]
+            {
+              return this->loaded.empty() || this->stopLoading;
+            });
+        if (this->stopLoading)
+        {
+          this->loadRunning = false;
+          return;
+        }
+        this->loaded.push_back(std::move(chunk));
+      }
+      this->ScheduleFlush();
+    }
+    while (first < count);
   }
-  return true;
+}
+
+//////////////////////////////////////////////////////
+void PlottingIfacePrivate::QueueExport(ExportJob &&_job,
+                                       PlottingInterface *_iface)
+{
+  std::lock_guard<std::mutex> lock(this->exportMutex);
+  this->exportJobs.push_back(std::move(_job));
+
+  if (this->exportRunning)
+    return;
+
+  // the previous thread is done with the queue
+  if (this->exportThread.joinable())
+    this->exportThread.join();
+
+  this->exportRunning = true;
+  this->exportThread = std::thread(&PlottingIfacePrivate::RunExports, this,
+      _iface);
+}
+
+//////////////////////////////////////////////////////
+void PlottingIfacePrivate::RunExports(PlottingInterface *_iface)
+{
+  while (true)
+  {
+    ExportJob job;
+    {
+      std::lock_guard<std::mutex> lock(this->exportMutex);
+      if (this->exportJobs.empty())
+      {
+        this->exportRunning = false;
+        return;
+      }
+      job = std::move(this->exportJobs.front());
+      this->exportJobs.pop_front();
+    }
+
+    size_t total = 0;
+    for (const auto &file : job.files)
+    {
+      for (const auto &column : file.columns)
+        total += column.size();
+    }
+
+    // report the progress of the job at most once per percent
+    size_t done = 0;
+    int lastPercent = -1;
+    auto progress = [&](size_t _written)
+    {
+      int percent = total ? static_cast<int>(100 * (done + _written) / total)
+                          : 100;
+      if (percent == lastPercent)
+        return;
+      lastPercent = percent;
+      QMetaObject::invokeMethod(_iface, "exportProgress",
+          Qt::QueuedConnection, Q_ARG(int, job.chart),
+          Q_ARG(double, percent * 0.01));
+    };
+
+    bool success = true;
+    for (const auto &file : job.files)
+    {
+      if (file.extension == "npy")
+        success = WriteNPY(file, progress) && success;
+      else if (file.extension == "json")
+        success = WriteText(file) && success;
+      else
+        success = WriteCSV(file, progress) && success;
+      for (const auto &column : file.columns)
+        done += column.size();
+    }
+
+    QMetaObject::invokeMethod(_iface, "exportFinished",
+        Qt::QueuedConnection, Q_ARG(int, job.chart), Q_ARG(bool, success));
+  }
+}
+
+//////////////////////////////////////////////////////
+bool PlottingIfacePrivate::WriteCSV(const ExportFile &_file,
+    const std::function<void(size_t)> &_progress)
+{
+  // buffer the stream to write large blocks instead of a flush per line
+  std::vector<char> buffer(EXPORT_BUFFER_SIZE);
+  std::ofstream file;
+  file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+
+  file.open(_file.path);
+  if (!file.is_open())
+  {
+    ignwarn << "[Couldn't open file: " << _file.path << "]" << std::endl;
+    return false;
+  }
+
+  // all the digits, as the rows are merged by time
+  file << std::setprecision(std::numeric_limits<double>::max_digits10);
+
+  file << "time";
+  for (const auto &name : _file.names)
+    file << ", " << name;
+  file << '\n';
+
+  // merge the columns by time, leaving the missing values empty
+  std::vector<int> heads(_file.columns.size(), 0);
+  size_t written = 0;
+  size_t rows = 0;
+  while (true)
+  {
+    double time = std::numeric_limits<double>::max();
+    bool found = false;
+    for (size_t c = 0; c < _file.columns.size(); ++c)
+    {
+      if (heads[c] < _file.columns[c].size())
+      {
+        time = std::min(time, _file.columns[c][heads[c]].x());
+        found = true;
+      }
+    }
+    if (!found)
+      break;
+
+    file << time;
+    for (size_t c = 0; c < _file.columns.size(); ++c)
+    {
+      file << ", ";
+      if (heads[c] < _file.columns[c].size() &&
+          _file.columns[c][heads[c]].x() <= time)
+      {
+        file << _file.columns[c][heads[c]].y();
+        ++heads[c];
+        ++written;
+      }
+    }
+    file << '\n';
+
+    if (++rows % 4096 == 0)
+      _progress(written);
+  }
+  _progress(written);
+
+  file.close();
+  return !file.fail();
+}
+
+//////////////////////////////////////////////////////
+bool PlottingIfacePrivate::WriteNPY(const ExportFile &_file,
+    const std::function<void(size_t)> &_progress)
+{
+  if (_file.columns.empty())
+    return false;
+  const auto &points = _file.columns.front();
+
+  std::ofstream file(_file.path, std::ios::binary);
+  if (!file.is_open())
+  {
+    ignwarn << "[Couldn't open file: " << _file.path << "]" << std::endl;
+    return false;
+  }
+
+  // npy format version 1.0: magic string, version, header length and a
+  // python dict describing the array, padded so the data is 64-bytes aligned
+  std::string header = std::string("{'descr': '") +
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+      "<f8"
+#else
+      ">f8"
+#endif
+      "', 'fortran_order': False, 'shape': (" +
+      std::to_string(points.size()) + ", 2), }";
+  const size_t preambleSize = 10;
+  size_t padding = 64 - (preambleSize + header.size() + 1) % 64;
+  header += std::string(padding % 64, ' ') + '\n';
+
+  uint16_t headerSize = header.size();
+  const char preamble[] = {'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0,
+      static_cast<char>(headerSize & 0xff),
+      static_cast<char>(headerSize >> 8)};
+  file.write(preamble, preambleSize);
+  file.write(header.data(), header.size());
+
+  // the points are already stored as (x, y) pairs of doubles
+  if (sizeof(QPointF) == 2 * sizeof(double))
+  {
+    file.write(reinterpret_cast<const char *>(points.constData()),
+        points.size() * sizeof(QPointF));
+  }
+  else
+  {
+    std::vector<double> values;
+    values.reserve(2 * points.size());
+    for (const auto &point : points)
+    {
+      values.push_back(point.x());
+      values.push_back(point.y());
+    }
+    file.write(reinterpret_cast<const char *>(values.data()),
+        values.size() * sizeof(double));
+  }
+  _progress(points.size());
+
+  file.close();
+  return !file.fail();
+}
+
+//////////////////////////////////////////////////////
+bool PlottingIfacePrivate::WriteText(const ExportFile &_file)
+{
+  std::ofstream file(_file.path);
+  if (!file.is_open())
+  {
+    ignwarn << "[Couldn't open file: " << _file.path << "]" << std::endl;
+    return false;
+  }
+
+  file << _file.text;
+  file.close();
+  return !file.fail();
 }
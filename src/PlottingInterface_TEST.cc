@@ -16,6 +16,12 @@
 */
 #include <gtest/gtest.h>
 
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <QDir>
+#include <QtCharts/QLineSeries>
+
 #ifdef _MSC_VER
 #pragma warning(push, 0)
 #endif
@@ -28,12 +34,56 @@
 #include <ignition/common/Console.hh>
 #include <ignition/utilities/ExtraTestMacros.hh>
 #include "test_config.h"  // NOLINT(build/include)
+#include "ignition/gui/Application.hh"
 #include "ignition/gui/Enums.hh"
 #include "ignition/gui/PlottingInterface.hh"
 
+int g_argc = 1;
+char **g_argv = new char *[g_argc];
+
 using namespace ignition;
 using namespace gui;
 
+/// \brief Read a whole file
+/// \param[in] _path File path
+/// \return Content of the file, empty if it can't be read
+static std::string ReadFile(const std::string &_path)
+{
+  std::ifstream file(_path, std::ios::binary);
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+/// \brief Wait until the exports of an interface are finished
+/// \param[in] _iface Plotting interface
+/// \param[in] _count Number of exports to wait for
+/// \return True if all the exports succeeded
+static bool WaitForExports(PlottingInterface &_iface, int _count)
+{
+  int finished = 0;
+  bool success = true;
+  auto connection = QObject::connect(&_iface,
+      &PlottingInterface::exportFinished, [&](int, bool _success)
+      {
+        finished++;
+        success = success && _success;
+      });
+
+  int sleep = 0;
+  int maxSleep = 30;
+  while (finished < _count && sleep < maxSleep)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    QCoreApplication::processEvents();
+    sleep++;
+  }
+  QObject::disconnect(connection);
+
+  EXPECT_EQ(finished, _count);
+  return success && finished == _count;
+}
+
 //////////////////////////////////////////////////
 // Disable test on windows until we fix "LNK2001 unresolved external symbol"
 // error
@@ -96,11 +146,11 @@ TEST(PlottingInterfaceTest, IGN_UTILS_TEST_DISABLED_ON_WIN32(Topic))
   EXPECT_EQ(static_cast<int>(fields["pose-position-x"]->Value()), 10);
   EXPECT_EQ(static_cast<int>(fields["pose-position-z"]->Value()), 15);
 
-  // ========== Callback Test with too small time diff ==========
+  // ========== Callback Test with small time diff ==========
   vector3d->set_x(20);
   vector3d->set_z(15);
 
-  // time diff < max diff
+  // time diff < reduction bucket period
   *time += 0.0001;
 
   // update the fields
@@ -108,8 +158,8 @@ TEST(PlottingInterfaceTest, IGN_UTILS_TEST_DISABLED_ON_WIN32(Topic))
 
   fields = topic.Fields();
 
-  // will not be set to 20 because the too small time diff
-  EXPECT_NE(static_cast<int>(fields["pose-position-x"]->Value()), 20);
+  // the value is updated, only the plotted points are reduced
+  EXPECT_EQ(static_cast<int>(fields["pose-position-x"]->Value()), 20);
 }
 
 //////////////////////////////////////////////////
@@ -142,11 +192,11 @@ TEST(PlottingInterfaceTest, IGN_UTILS_TEST_DISABLED_ON_WIN32(HeaderTime))
 
   EXPECT_EQ(static_cast<int>(fields["data"]->Value()), 10);
 
-  // ======== Header time with too small time diff ==========
+  // ======== Header time with small time diff ==========
 
   msg.set_data(20);
 
-  // time diff < max diff
+  // time diff < reduction bucket period
   stamp->set_sec(currentTime);
   stamp->set_nsec(1);
 
@@ -155,8 +205,9 @@ TEST(PlottingInterfaceTest, IGN_UTILS_TEST_DISABLED_ON_WIN32(HeaderTime))
 
   fields = topic.Fields();
 
-  // will not be set to 20 because the too small time diff
-  EXPECT_NE(static_cast<int>(fields["data"]->Value()), 20);
+  // the value is updated, only the plotted points are reduced
+  EXPECT_EQ(static_cast<int>(fields["data"]->Value()), 20);
+  EXPECT_NEAR(fields["data"]->Time(), currentTime + 1e-9, 1e-12);
 }
 
 //////////////////////////////////////////////////
@@ -243,3 +294,658 @@ TEST(PlottingInterfaceTest, IGN_UTILS_TEST_DISABLED_ON_WIN32(Transport))
   topics = transport.Topics();
   EXPECT_EQ(static_cast<int>(topics.size()), 1);
 }
+
+//////////////////////////////////////////////////
+// Disable test on windows until we fix "LNK2001 unresolved external symbol"
+// error
+TEST(PlottingInterfaceTest, IGN_UTILS_TEST_DISABLED_ON_WIN32(FieldTypeChange))
+{
+  common::Console::SetVerbosity(4);
+
+  double *time = new double;
+  *time = 10;
+  std::shared_ptr<double> timeRef(time);
+
+  auto topic = Topic("");
+  topic.SetPlottingTimeRef(timeRef);
+  topic.Register("position-x", 1);
+
+  // resolve the path against a pose message
+  msgs::Pose poseMsg;
+  poseMsg.mutable_position()->set_x(3);
+  topic.Callback(poseMsg);
+
+  auto fields = topic.Fields();
+  EXPECT_EQ(static_cast<int>(fields["position-x"]->Value()), 3);
+
+  // the path doesn't exist in a vector message, so the value isn't updated
+  msgs::Vector3d vectorMsg;
+  vectorMsg.set_x(4);
+  *time += 1;
+  topic.Callback(vectorMsg);
+
+  fields = topic.Fields();
+  EXPECT_EQ(static_cast<int>(fields["position-x"]->Value()), 3);
+
+  // the path is resolved again when the pose messages come back
+  poseMsg.mutable_position()->set_x(5);
+  *time += 1;
+  topic.Callback(poseMsg);
+
+  fields = topic.Fields();
+  EXPECT_EQ(static_cast<int>(fields["position-x"]->Value()), 5);
+}
+
+//////////////////////////////////////////////////
+// Disable test on windows until we fix "LNK2001 unresolved external symbol"
+// error
+TEST(PlottingInterfaceTest, IGN_UTILS_TEST_DISABLED_ON_WIN32(PlotSeries))
+{
+  PlotSeries series(3);
+  EXPECT_EQ(series.Capacity(), 3);
+  EXPECT_EQ(series.Count(), 0);
+  EXPECT_TRUE(series.Points().isEmpty());
+
+  series.Append(QPointF(1, 10));
+  series.Append(QPointF(2, 20));
+  EXPECT_EQ(series.Count(), 2);
+  EXPECT_DOUBLE_EQ(series.At(0).x(), 1);
+  EXPECT_DOUBLE_EQ(series.At(1).y(), 20);
+
+  // out of range
+  EXPECT_EQ(series.At(2), QPointF());
+  EXPECT_EQ(series.At(-1), QPointF());
+
+  // the oldest points are dropped once the series is full
+  series.Append(QPointF(3, 30));
+  series.Append(QPointF(4, 40));
+  series.Append(QPointF(5, 50));
+  EXPECT_EQ(series.Count(), 3);
+
+  auto points = series.Points();
+  ASSERT_EQ(points.size(), 3);
+  EXPECT_DOUBLE_EQ(points[0].x(), 3);
+  EXPECT_DOUBLE_EQ(points[1].x(), 4);
+  EXPECT_DOUBLE_EQ(points[2].x(), 5);
+  EXPECT_DOUBLE_EQ(series.At(0).y(), 30);
+
+  series.Clear();
+  EXPECT_EQ(series.Count(), 0);
+  EXPECT_EQ(series.Capacity(), 3);
+
+  series.Append(QPointF(6, 60));
+  EXPECT_DOUBLE_EQ(series.At(0).x(), 6);
+}
+
+//////////////////////////////////////////////////
+// Disable test on windows until we fix "LNK2001 unresolved external symbol"
+// error
+TEST(PlottingInterfaceTest, IGN_UTILS_TEST_DISABLED_ON_WIN32(PlotSeriesRange))
+{
+  PlotSeries series(1000);
+  for (int i = 0; i < 1000; ++i)
+    series.Append(QPointF(i, i % 10 == 5 ? 100 : i % 10));
+
+  // few enough points: the raw points, with one point out of each side
+  auto points = series.Points(100, 110, 100);
+  ASSERT_EQ(points.size(), 13);
+  EXPECT_DOUBLE_EQ(points.front().x(), 99);
+  EXPECT_DOUBLE_EQ(points.back().x(), 111);
+
+  // too many points: min & max of buckets, keeping the peaks
+  points = series.Points(0, 999, 100);
+  EXPECT_LE(points.size(), 100);
+  EXPECT_GT(points.size(), 10);
+
+  double maxY = 0;
+  double minY = 100;
+  for (int i = 0; i < points.size(); ++i)
+  {
+    maxY = std::max(maxY, points[i].y());
+    minY = std::min(minY, points[i].y());
+    if (i > 0)
+      EXPECT_LE(points[i - 1].x(), points[i].x());
+  }
+  EXPECT_DOUBLE_EQ(maxY, 100);
+  EXPECT_DOUBLE_EQ(minY, 0);
+
+  // the coarse levels keep the history of the dropped raw points
+  for (int i = 1000; i < 5000; ++i)
+    series.Append(QPointF(i, i % 10 == 5 ? 100 : i % 10));
+  EXPECT_EQ(series.Count(), 1000);
+  EXPECT_DOUBLE_EQ(series.At(0).x(), 4000);
+
+  points = series.Points(0, 4999, 200);
+  ASSERT_FALSE(points.isEmpty());
+  EXPECT_LE(points.size(), 200);
+  EXPECT_LT(points.front().x(), 100);
+  EXPECT_GE(points.back().x(), 4900);
+
+  // empty range
+  EXPECT_TRUE(series.Points(10, 5, 100).isEmpty());
+  EXPECT_TRUE(PlotSeries(10).Points(0, 10, 100).isEmpty());
+}
+
+//////////////////////////////////////////////////
+// Disable test on windows until we fix "LNK2001 unresolved external symbol"
+// error
+TEST(PlottingInterfaceTest, IGN_UTILS_TEST_DISABLED_ON_WIN32(PlotSeriesReset))
+{
+  PlotSeries series(1000);
+  for (int i = 0; i < 500; ++i)
+    EXPECT_DOUBLE_EQ(series.Append(QPointF(i, i)).x(), i);
+
+  // the time goes back to 0, the points continue from the last one
+  for (int i = 0; i < 500; ++i)
+    EXPECT_DOUBLE_EQ(series.Append(QPointF(i, -i)).x(), 499 + i);
+
+  for (int i = 1; i < series.Count(); ++i)
+    EXPECT_LE(series.At(i - 1).x(), series.At(i).x());
+
+  // ranges on both sides of the reset
+  auto points = series.Points(100, 110, 100);
+  ASSERT_EQ(points.size(), 13);
+  EXPECT_DOUBLE_EQ(points.front().x(), 99);
+  EXPECT_DOUBLE_EQ(points.front().y(), 99);
+
+  points = series.Points(600, 610, 100);
+  ASSERT_EQ(points.size(), 13);
+  EXPECT_DOUBLE_EQ(points.front().x(), 599);
+  EXPECT_DOUBLE_EQ(points.front().y(), -100);
+
+  // the buckets cover the whole series too
+  points = series.Points(0, 998, 100);
+  ASSERT_FALSE(points.isEmpty());
+  EXPECT_LE(points.size(), 100);
+  EXPECT_LT(points.front().x(), 10);
+  EXPECT_GT(points.back().x(), 990);
+  EXPECT_DOUBLE_EQ(points.back().y(), -499);
+
+  // clearing the series resets the offset
+  series.Clear();
+  EXPECT_DOUBLE_EQ(series.Append(QPointF(5, 1)).x(), 5);
+}
+
+//////////////////////////////////////////////////
+// Disable test on windows until we fix "LNK2001 unresolved external symbol"
+// error
+TEST(PlottingInterfaceTest, IGN_UTILS_TEST_DISABLED_ON_WIN32(SteadyClockTime))
+{
+  common::Console::SetVerbosity(4);
+
+  // msg without header and without plotting time ref
+  msgs::Int32 msg;
+  msg.set_data(10);
+
+  auto topic = Topic("");
+  topic.Register("data", 1);
+
+  topic.Callback(msg);
+
+  auto fields = topic.Fields();
+  EXPECT_EQ(static_cast<int>(fields["data"]->Value()), 10);
+  double firstTime = fields["data"]->Time();
+  EXPECT_GE(firstTime, 0.0);
+
+  // the next message is stamped with its reception time
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  msg.set_data(20);
+  topic.Callback(msg);
+
+  fields = topic.Fields();
+  EXPECT_EQ(static_cast<int>(fields["data"]->Value()), 20);
+  EXPECT_GE(fields["data"]->Time() - firstTime, 0.05);
+}
+
+//////////////////////////////////////////////////
+// Disable test on windows until we fix "LNK2001 unresolved external symbol"
+// error
+TEST(PlottingInterfaceTest, IGN_UTILS_TEST_DISABLED_ON_WIN32(PlotHistory))
+{
+  common::Console::SetVerbosity(4);
+
+  auto directory = std::string(PROJECT_BINARY_PATH) + "/test_plot_history";
+  std::string fieldID = "/collision-pose-position-x";
+  auto path = PlotHistory::FilePath(directory, fieldID);
+  EXPECT_EQ(path, directory + "/%2Fcollision%2Dpose%2Dposition%2Dx.plot");
+
+  // fields whose names only differ by their separators have their own logs
+  EXPECT_NE(PlotHistory::FilePath(directory, "/a_b-c"),
+      PlotHistory::FilePath(directory, "/a/b-c"));
+  EXPECT_NE(PlotHistory::FilePath(directory, "/a%2Fb-c"),
+      PlotHistory::FilePath(directory, "/a/b-c"));
+
+  QDir(QString::fromStdString(directory)).removeRecursively();
+
+  // log the values of a field
+  double *time = new double;
+  *time = 10;
+  std::shared_ptr<double> timeRef(time);
+
+  {
+    auto topic = Topic("/collision");
+    topic.SetPlottingTimeRef(timeRef);
+    topic.SetHistoryDirectory(directory);
+    topic.Register("pose-position-x", 1);
+
+    msgs::Collision msg;
+    for (int i = 0; i < 5000; ++i)
+    {
+      msg.mutable_pose()->mutable_position()->set_x(i);
+      *time += 1;
+      topic.Callback(msg);
+    }
+  }
+
+  // the log outlives the topic, and grew past its initial size
+  PlotHistory history;
+  ASSERT_TRUE(history.Open(path, fieldID, true));
+  EXPECT_EQ(history.Count(), 5000u);
+
+  auto points = history.Points();
+  ASSERT_EQ(points.size(), 5000);
+  EXPECT_DOUBLE_EQ(points.front().x(), 11);
+  EXPECT_DOUBLE_EQ(points.front().y(), 0);
+  EXPECT_DOUBLE_EQ(points.back().x(), 5010);
+  EXPECT_DOUBLE_EQ(points.back().y(), 4999);
+
+  // read-only logs can't be appended
+  EXPECT_FALSE(history.Append(1, 1));
+  history.Close();
+  EXPECT_FALSE(history.IsOpen());
+
+  // the log of another field isn't opened
+  EXPECT_FALSE(history.Open(path, "/collision-pose-position-y"));
+  EXPECT_FALSE(history.Open(path, "/collision-pose-position"));
+  EXPECT_FALSE(history.IsOpen());
+
+  // appending to an existing log keeps its records, and its times if they
+  // follow the log
+  ASSERT_TRUE(history.Open(path, fieldID));
+  EXPECT_EQ(history.Segments(), 1u);
+  EXPECT_TRUE(history.Append(6000, 1));
+  EXPECT_EQ(history.Count(), 5001u);
+  EXPECT_DOUBLE_EQ(history.Offset(), 0);
+
+  // a new session stamped from its start continues the log
+  ASSERT_TRUE(history.Open(path, fieldID));
+  EXPECT_TRUE(history.Append(1, 2));
+  EXPECT_TRUE(history.Append(2, 3));
+  EXPECT_EQ(history.Segments(), 2u);
+  EXPECT_NEAR(history.Offset(), 5999, 1e-6);
+
+  // so does a time reset within a session
+  EXPECT_TRUE(history.Append(0, 4));
+  EXPECT_EQ(history.Segments(), 3u);
+  EXPECT_NEAR(history.Offset(), 6001, 1e-6);
+
+  // the records stay sorted by time, and the segments don't overlap
+  points = history.Points(5000, 10);
+  ASSERT_EQ(points.size(), 4);
+  EXPECT_DOUBLE_EQ(points[0].x(), 6000);
+  EXPECT_GT(points[1].x(), 6000);
+  EXPECT_NEAR(points[1].x(), 6000, 1e-6);
+  EXPECT_NEAR(points[2].x(), 6001, 1e-6);
+  EXPECT_GT(points[3].x(), points[2].x());
+  EXPECT_DOUBLE_EQ(points[3].y(), 4);
+  EXPECT_TRUE(history.Points(5004, 10).isEmpty());
+
+  // read-only logs aren't created
+  PlotHistory missing;
+  EXPECT_FALSE(missing.Open(directory + "/missing.plot", "missing", true));
+
+  QDir(QString::fromStdString(directory)).removeRecursively();
+}
+
+//////////////////////////////////////////////////
+// Disable test on windows until we fix "LNK2001 unresolved external symbol"
+// error
+TEST(PlottingInterfaceTest, IGN_UTILS_TEST_DISABLED_ON_WIN32(HasHeader))
+{
+  auto topic = Topic("");
+  double time = -1;
+
+  // header not set
+  msgs::Int32 msg;
+  EXPECT_FALSE(topic.HasHeader(msg, time));
+
+  msg.mutable_header()->mutable_stamp()->set_sec(3);
+  msg.mutable_header()->mutable_stamp()->set_nsec(500000000);
+  EXPECT_TRUE(topic.HasHeader(msg, time));
+  EXPECT_DOUBLE_EQ(time, 3.5);
+
+  // header without stamp
+  msgs::Pose pose;
+  pose.mutable_header();
+  EXPECT_TRUE(topic.HasHeader(pose, time));
+  EXPECT_DOUBLE_EQ(time, 0);
+
+  // message type without header
+  msgs::Time stamp;
+  stamp.set_sec(10);
+  EXPECT_FALSE(topic.HasHeader(stamp, time));
+
+  // back to the first message type
+  EXPECT_TRUE(topic.HasHeader(msg, time));
+  EXPECT_DOUBLE_EQ(time, 3.5);
+}
+
+//////////////////////////////////////////////////
+// Disable test on windows until we fix "LNK2001 unresolved external symbol"
+// error
+TEST(PlottingInterfaceTest, IGN_UTILS_TEST_DISABLED_ON_WIN32(Reduction))
+{
+  common::Console::SetVerbosity(4);
+
+  double *time = new double;
+  *time = 0;
+  std::shared_ptr<double> timeRef(time);
+
+  auto topic = Topic("");
+  topic.SetPlottingTimeRef(timeRef);
+  topic.Register("data", 1);
+
+  std::vector<QPointF> points;
+  QObject::connect(&topic, &Topic::plot,
+      [&](int, QString, double _x, double _y)
+      {
+        points.push_back(QPointF(_x, _y));
+      });
+  int pendingBuckets = 0;
+  QObject::connect(&topic, &Topic::reductionPending,
+      [&]() {pendingBuckets++;});
+
+  // publish 1 s of a 1 kHz signal, with a peak every 100 ms
+  msgs::Int32 msg;
+  auto publish = [&]()
+  {
+    points.clear();
+    pendingBuckets = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+      *time = i * 0.001;
+      msg.set_data(i % 100 == 50 ? 100 : i % 2);
+      topic.Callback(msg);
+    }
+  };
+
+  // unknown field
+  EXPECT_FALSE(topic.SetReduction("unknown", PlotReduction::KEEP_ALL, 0));
+
+  // keep all
+  EXPECT_TRUE(topic.SetReduction("data", PlotReduction::KEEP_ALL, 0));
+  publish();
+  EXPECT_EQ(points.size(), 1000u);
+
+  // every Nth
+  EXPECT_FALSE(topic.SetReduction("data", PlotReduction::EVERY_NTH, 0));
+  EXPECT_TRUE(topic.SetReduction("data", PlotReduction::EVERY_NTH, 10));
+  publish();
+  ASSERT_EQ(points.size(), 100u);
+  EXPECT_DOUBLE_EQ(points[1].x(), 0.01);
+
+  // min/max of 10 ms buckets: first, min and max of each bucket, keeping the
+  // peaks
+  EXPECT_FALSE(topic.SetReduction("data", PlotReduction::MIN_MAX, 0));
+  EXPECT_TRUE(topic.SetReduction("data", PlotReduction::MIN_MAX, 0.01));
+  publish();
+  EXPECT_LE(points.size(), 300u);
+  EXPECT_GE(points.size(), 200u);
+  int peaks = 0;
+  for (const auto &point : points)
+  {
+    if (static_cast<int>(point.y()) == 100)
+      peaks++;
+  }
+  EXPECT_EQ(peaks, 10);
+
+  // mean of 100 ms buckets, the last bucket isn't complete yet
+  EXPECT_TRUE(topic.SetReduction("data", PlotReduction::MEAN, 0.1));
+  publish();
+  ASSERT_EQ(points.size(), 9u);
+  EXPECT_NEAR(points[0].x(), 0.0495, 1e-6);
+  EXPECT_NEAR(points[0].y(), 1.5, 1e-6);
+
+  // each bucket is notified when its first value isn't plotted yet
+  EXPECT_EQ(pendingBuckets, 10);
+
+  // the last bucket is plotted once no value was added for a bucket period
+  EXPECT_LE(topic.FlushReductions(), 0.1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(150));
+  EXPECT_LT(topic.FlushReductions(), 0);
+  ASSERT_EQ(points.size(), 10u);
+  EXPECT_NEAR(points[9].x(), 0.9495, 1e-6);
+  EXPECT_LT(topic.FlushReductions(), 0);
+  EXPECT_EQ(points.size(), 10u);
+
+  // a single value, like a latched topic, is plotted once its bucket
+  // expires
+  EXPECT_TRUE(topic.SetReduction("data", PlotReduction::MEAN, 0.2));
+  points.clear();
+  pendingBuckets = 0;
+  *time = 2;
+  msg.set_data(7);
+  topic.Callback(msg);
+  EXPECT_TRUE(points.empty());
+  EXPECT_EQ(pendingBuckets, 1);
+  double expiry = topic.FlushReductions();
+  EXPECT_GT(expiry, 0);
+  EXPECT_LE(expiry, 0.2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  EXPECT_LT(topic.FlushReductions(), 0);
+  ASSERT_EQ(points.size(), 1u);
+  EXPECT_DOUBLE_EQ(points[0].x(), 2);
+  EXPECT_DOUBLE_EQ(points[0].y(), 7);
+
+  // the value is always updated
+  EXPECT_EQ(static_cast<int>(topic.Fields()["data"]->Value()), 7);
+}
+
+//////////////////////////////////////////////////
+// Disable test on windows until we fix "LNK2001 unresolved external symbol"
+// error
+TEST(PlottingInterfaceTest, IGN_UTILS_TEST_DISABLED_ON_WIN32(Export))
+{
+  common::Console::SetVerbosity(4);
+  Application app(g_argc, g_argv);
+  PlottingInterface iface;
+
+  auto directory = std::string(PROJECT_BINARY_PATH) + "/test_plot_export";
+  QDir(QString::fromStdString(directory)).removeRecursively();
+  ASSERT_TRUE(QDir().mkpath(QString::fromStdString(directory)));
+  auto url = QString::fromStdString("file://" + directory);
+
+  // the first series is registered, so its stored points are exported
+  QtCharts::QLineSeries lineSeries;
+  iface.registerSeries(1, "pose-x", &lineSeries, 100);
+  iface.onPlot(1, "pose-x", 0.5, 1);
+  iface.onPlot(1, "pose-x", 1, 2);
+  iface.onPlot(1, "pose-x", 1.5, 3);
+
+  bool updated = false;
+  auto connection = QObject::connect(&iface, &PlottingInterface::plotUpdated,
+      [&](int, double, double, double, double) {updated = true;});
+  int sleep = 0;
+  int maxSleep = 30;
+  while (!updated && sleep < maxSleep)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    QCoreApplication::processEvents();
+    sleep++;
+  }
+  QObject::disconnect(connection);
+  ASSERT_TRUE(updated);
+
+  // the second one only has the points drawn by the chart
+  QVariantList drawnPoints;
+  drawnPoints.append(QPointF(1, -1));
+  drawnPoints.append(QPointF(2, -2));
+  QMap<QString, QVariant> serieses;
+  serieses["pose-x"] = QVariantList();
+  serieses["pose-y"] = drawnPoints;
+
+  // ============== CSV file per series =============
+  ASSERT_TRUE(iface.exportCSV(url, 1, serieses));
+  ASSERT_TRUE(WaitForExports(iface, 1));
+
+  EXPECT_EQ(ReadFile(iface.FilePath(url, "Plot1_pose/x", "csv")),
+      "time, pose/x\n0.5, 1\n1, 2\n1.5, 3\n");
+  EXPECT_EQ(ReadFile(iface.FilePath(url, "Plot1_pose/y", "csv")),
+      "time, pose/y\n1, -1\n2, -2\n");
+
+  // ============== Merged CSV file =============
+  // rows are merged by time, leaving the missing values empty
+  ASSERT_TRUE(iface.exportMergedCSV(url, 1, serieses));
+  ASSERT_TRUE(WaitForExports(iface, 1));
+
+  EXPECT_EQ(ReadFile(iface.FilePath(url, "Plot1", "csv")),
+      "time, pose/x, pose/y\n"
+      "0.5, 1, \n"
+      "1, 2, -1\n"
+      "1.5, 3, \n"
+      "2, , -2\n");
+
+  // times and values are written with all their digits, so samples
+  // milliseconds apart after a long run keep their own rows
+  QVariantList precisePoints;
+  precisePoints.append(QPointF(1000.001, 0.1));
+  precisePoints.append(QPointF(1000.002, 1.0 / 3));
+  QMap<QString, QVariant> preciseSerieses;
+  preciseSerieses["pose-z"] = precisePoints;
+  ASSERT_TRUE(iface.exportMergedCSV(url, 2, preciseSerieses));
+  ASSERT_TRUE(WaitForExports(iface, 1));
+
+  std::istringstream csv(ReadFile(iface.FilePath(url, "Plot2", "csv")));
+  std::string line;
+  ASSERT_TRUE(std::getline(csv, line));
+  EXPECT_EQ(line, "time, pose/z");
+  for (const auto &point : {QPointF(1000.001, 0.1), QPointF(1000.002, 1.0 / 3)})
+  {
+    ASSERT_TRUE(std::getline(csv, line));
+    auto comma = line.find(", ");
+    ASSERT_NE(comma, std::string::npos);
+    EXPECT_EQ(std::stod(line.substr(0, comma)), point.x());
+    EXPECT_EQ(std::stod(line.substr(comma + 2)), point.y());
+  }
+  EXPECT_FALSE(std::getline(csv, line));
+
+  // ============== NPY files and JSON sidecar =============
+  ASSERT_TRUE(iface.exportNPY(url, 1, serieses));
+  ASSERT_TRUE(WaitForExports(iface, 1));
+
+  auto npy = ReadFile(iface.FilePath(url, "Plot1_pose/x", "npy"));
+  ASSERT_GT(npy.size(), 10u);
+  EXPECT_EQ(npy.substr(0, 6), "\x93NUMPY");
+  EXPECT_EQ(npy[6], 1);
+  EXPECT_EQ(npy[7], 0);
+
+  // the header is padded so the data is 64-bytes aligned
+  size_t headerSize = static_cast<unsigned char>(npy[8]) |
+      (static_cast<unsigned char>(npy[9]) << 8);
+  size_t dataStart = 10 + headerSize;
+  EXPECT_EQ(dataStart % 64, 0u);
+  ASSERT_EQ(npy.size(), dataStart + 3 * 2 * sizeof(double));
+
+  auto header = npy.substr(10, headerSize);
+  EXPECT_NE(header.find("'descr': '<f8'"), std::string::npos);
+  EXPECT_NE(header.find("'fortran_order': False"), std::string::npos);
+  EXPECT_NE(header.find("'shape': (3, 2)"), std::string::npos);
+  EXPECT_EQ(header.back(), '\n');
+
+  // (time, value) rows of little-endian doubles
+  double values[6];
+  std::memcpy(values, npy.data() + dataStart, sizeof(values));
+  EXPECT_DOUBLE_EQ(values[0], 0.5);
+  EXPECT_DOUBLE_EQ(values[1], 1);
+  EXPECT_DOUBLE_EQ(values[4], 1.5);
+  EXPECT_DOUBLE_EQ(values[5], 3);
+
+  npy = ReadFile(iface.FilePath(url, "Plot1_pose/y", "npy"));
+  ASSERT_GT(npy.size(), 10u);
+  headerSize = static_cast<unsigned char>(npy[8]) |
+      (static_cast<unsigned char>(npy[9]) << 8);
+  EXPECT_NE(npy.substr(10, headerSize).find("'shape': (2, 2)"),
+      std::string::npos);
+  EXPECT_EQ(npy.size(), 10 + headerSize + 2 * 2 * sizeof(double));
+
+  auto jsonPath = iface.FilePath(url, "Plot1", "json");
+  auto json = ReadFile(jsonPath);
+  auto fileName = [&](const std::string &_name)
+  {
+    auto path = iface.FilePath(url, _name, "npy");
+    return path.substr(path.rfind('/') + 1);
+  };
+  EXPECT_NE(json.find("\"chart\": 1"), std::string::npos);
+  EXPECT_NE(json.find("{\"name\": \"pose/x\", \"file\": \"" +
+      fileName("Plot1_pose/x") +
+      "\", \"columns\": [\"time\", \"value\"], \"count\": 3}"),
+      std::string::npos) << json;
+  EXPECT_NE(json.find("{\"name\": \"pose/y\", \"file\": \"" +
+      fileName("Plot1_pose/y") +
+      "\", \"columns\": [\"time\", \"value\"], \"count\": 2}"),
+      std::string::npos) << json;
+
+  QDir(QString::fromStdString(directory)).removeRecursively();
+}
+
+//////////////////////////////////////////////////
+// Disable test on windows until we fix "LNK2001 unresolved external symbol"
+// error
+TEST(PlottingInterfaceTest, IGN_UTILS_TEST_DISABLED_ON_WIN32(HistoryReplay))
+{
+  common::Console::SetVerbosity(4);
+  Application app(g_argc, g_argv);
+  PlottingInterface iface;
+
+  auto directory = std::string(PROJECT_BINARY_PATH) + "/test_plot_replay";
+  QDir(QString::fromStdString(directory)).removeRecursively();
+  ASSERT_TRUE(QDir().mkpath(QString::fromStdString(directory)));
+  iface.SetHistoryDirectory(directory);
+
+  // log of a previous session
+  {
+    PlotHistory history;
+    ASSERT_TRUE(history.Open(PlotHistory::FilePath(directory, "pose-x"),
+        "pose-x"));
+    for (int i = 1; i <= 10; ++i)
+      EXPECT_TRUE(history.Append(i, i));
+  }
+
+  // the log is loaded in the background, and the received points are held
+  // until it is loaded, the ones that were logged being skipped
+  QtCharts::QLineSeries lineSeries;
+  iface.registerSeries(1, "pose-x", &lineSeries, 100);
+  iface.onPlot(1, "pose-x", 9, 9);
+  iface.onPlot(1, "pose-x", 10, 10);
+  iface.onPlot(1, "pose-x", 11, 11);
+
+  double maxX = 0;
+  auto connection = QObject::connect(&iface, &PlottingInterface::plotUpdated,
+      [&](int, double, double _maxX, double, double)
+      {
+        maxX = std::max(maxX, _maxX);
+      });
+  int sleep = 0;
+  int maxSleep = 30;
+  while (maxX < 11 && sleep < maxSleep)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    QCoreApplication::processEvents();
+    sleep++;
+  }
+  QObject::disconnect(connection);
+  EXPECT_DOUBLE_EQ(maxX, 11);
+
+  QMap<QString, QVariant> serieses;
+  serieses["pose-x"] = QVariantList();
+  auto url = QString::fromStdString("file://" + directory);
+  ASSERT_TRUE(iface.exportCSV(url, 1, serieses));
+  ASSERT_TRUE(WaitForExports(iface, 1));
+
+  std::string expected = "time, pose/x\n";
+  for (int i = 1; i <= 11; ++i)
+    expected += std::to_string(i) + ", " + std::to_string(i) + "\n";
+  EXPECT_EQ(ReadFile(iface.FilePath(url, "Plot1_pose/x", "csv")), expected);
+
+  QDir(QString::fromStdString(directory)).removeRecursively();
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_GUI_PLUGINS_FRAMEMAILBOX_HH_
+#define IGNITION_GUI_PLUGINS_FRAMEMAILBOX_HH_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
+namespace ignition
+{
+namespace gui
+{
+namespace plugins
+{
+  /// \brief Latest-wins handoff of frames from the transport thread to the
+  /// conversion thread. A frame posted before the previous one was taken
+  /// replaces it, so only the newest frame is converted and the conversion
+  /// never falls behind.
+  template<typename T>
+  class FrameMailbox
+  {
+    /// \brief Post a frame, replacing the frame waiting to be taken
+    /// \param[in] _frame Frame
+    /// \return True if a frame was replaced
+    public: bool Post(T _frame)
+    {
+      // the replaced frame is released after the lock, in _frame
+      bool replaced;
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        std::swap(this->frame, _frame);
+        replaced = this->pending;
+        this->pending = true;
+      }
+      this->cv.notify_one();
+
+      ++this->received;
+      if (replaced)
+        ++this->dropped;
+      return replaced;
+    }
+
+    /// \brief Wait for a frame and take it
+    /// \param[out] _frame Latest frame posted
+    /// \return False if the mailbox was stopped
+    public: bool Take(T &_frame)
+    {
+      T taken{};
+      {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->cv.wait(lock, [this]
+            {
+              return this->stopped || this->pending;
+            });
+        if (this->stopped)
+          return false;
+
+        std::swap(taken, this->frame);
+        this->pending = false;
+      }
+      std::swap(_frame, taken);
+      return true;
+    }
+
+    /// \brief Stop the mailbox, waking up the thread waiting in Take()
+    public: void Stop()
+    {
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopped = true;
+      }
+      this->cv.notify_all();
+    }
+
+    /// \brief Number of frames posted
+    /// \return Number of frames
+    public: int Received() const
+    {
+      return this->received;
+    }
+
+    /// \brief Number of frames replaced by a newer one before they were
+    /// taken
+    /// \return Number of frames
+    public: int Dropped() const
+    {
+      return this->dropped;
+    }
+
+    /// \brief Protects the frame and the flags
+    private: std::mutex mutex;
+
+    /// \brief Notifies the thread waiting in Take() of new frames
+    private: std::condition_variable cv;
+
+    /// \brief Latest frame, waiting to be taken
+    private: T frame{};
+
+    /// \brief True if a frame is waiting to be taken
+    private: bool pending = false;
+
+    /// \brief True once stopped
+    private: bool stopped = false;
+
+    /// \brief Number of frames posted
+    private: std::atomic<int> received{0};
+
+    /// \brief Number of frames replaced before they were taken
+    private: std::atomic<int> dropped{0};
+  };
+}
+}
+}
+
+#endif
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "FrameMailbox.hh"
+
+using namespace ignition;
+using namespace gui;
+using namespace plugins;
+
+/////////////////////////////////////////////////
+TEST(FrameMailboxTest, LatestWins)
+{
+  FrameMailbox<int> frames;
+  EXPECT_FALSE(frames.Post(1));
+  EXPECT_TRUE(frames.Post(2));
+  EXPECT_TRUE(frames.Post(3));
+  EXPECT_EQ(3, frames.Received());
+  EXPECT_EQ(2, frames.Dropped());
+
+  // only the newest frame is taken
+  int frame = 0;
+  EXPECT_TRUE(frames.Take(frame));
+  EXPECT_EQ(3, frame);
+
+  EXPECT_FALSE(frames.Post(4));
+  EXPECT_TRUE(frames.Take(frame));
+  EXPECT_EQ(4, frame);
+  EXPECT_EQ(4, frames.Received());
+  EXPECT_EQ(2, frames.Dropped());
+}
+
+/////////////////////////////////////////////////
+TEST(FrameMailboxTest, Release)
+{
+  // the replaced and the taken frames aren't kept by the mailbox
+  FrameMailbox<std::shared_ptr<int>> frames;
+  auto first = std::make_shared<int>(1);
+  auto second = std::make_shared<int>(2);
+  frames.Post(first);
+  frames.Post(second);
+  EXPECT_EQ(1, first.use_count());
+
+  std::shared_ptr<int> frame;
+  EXPECT_TRUE(frames.Take(frame));
+  EXPECT_EQ(second, frame);
+  frame.reset();
+  EXPECT_EQ(1, second.use_count());
+}
+
+/////////////////////////////////////////////////
+TEST(FrameMailboxTest, Stop)
+{
+  FrameMailbox<int> frames;
+
+  // wakes up the waiting thread
+  std::thread thread([&frames]
+  {
+    int frame = 0;
+    EXPECT_FALSE(frames.Take(frame));
+  });
+  frames.Stop();
+  thread.join();
+
+  int frame = 0;
+  frames.Post(1);
+  EXPECT_FALSE(frames.Take(frame));
+}
+
+/////////////////////////////////////////////////
+TEST(FrameMailboxTest, Threads)
+{
+  FrameMailbox<int> frames;
+  const int kFrames = 100000;
+
+  // a consumer slower than the producer, so frames are usually dropped
+  std::atomic<int> converted{0};
+  std::atomic<int> last{0};
+  bool ordered = true;
+  std::thread converter([&]
+  {
+    int frame = 0;
+    while (frames.Take(frame))
+    {
+      if (frame <= last)
+        ordered = false;
+      last = frame;
+      ++converted;
+      if (frame == kFrames)
+        return;
+      std::this_thread::yield();
+    }
+  });
+
+  for (int i = 1; i <= kFrames; ++i)
+    frames.Post(i);
+  converter.join();
+
+  // the newest frame is always converted, the others are either converted
+  // or dropped, in order
+  EXPECT_TRUE(ordered);
+  EXPECT_EQ(kFrames, last);
+  EXPECT_EQ(kFrames, frames.Received());
+  EXPECT_EQ(frames.Received(), converted + frames.Dropped());
+}
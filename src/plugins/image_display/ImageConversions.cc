@@ -0,0 +1,545 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define IGN_GUI_IMAGE_SSE2
+  #include <emmintrin.h>
+#endif
+
+#include "ImageConversions.hh"
+
+namespace ignition
+{
+namespace gui
+{
+namespace plugins
+{
+  /// \brief Converters by pixel format
+  class ConverterRegistry
+  {
+    /// \brief Constructor, registers the built-in converters
+    public: ConverterRegistry();
+
+    /// \brief Protects the converters
+    public: std::mutex mutex;
+
+    /// \brief Converters by pixel format
+    public: std::map<msgs::PixelFormatType, conversions::Converter> converters;
+  };
+}
+}
+}
+
+using namespace ignition;
+using namespace gui;
+using namespace plugins;
+
+/// \brief Read a sample which may not be aligned
+/// \param[in] _data Samples
+/// \param[in] _i Index of the sample
+/// \return The sample
+template<typename T>
+static T Sample(const unsigned char *_data, std::size_t _i)
+{
+  T value;
+  std::memcpy(&value, _data + _i * sizeof(T), sizeof(T));
+  return value;
+}
+
+/// \brief Clamp a gray value to [0, 255] and round it. NaN is clamped to 255,
+/// like the SSE2 path does.
+/// \param[in] _value Gray value
+/// \return 8-bit gray value
+static uint8_t ToGray8(float _value)
+{
+  // Written so a NaN fails the first comparison
+  float value = _value < 255.0f ? _value : 255.0f;
+  value = std::max(0.0f, value);
+  return static_cast<uint8_t>(std::lrint(value));
+}
+
+/////////////////////////////////////////////////
+void conversions::MinMax(const unsigned char *_data, std::size_t _count,
+    float &_min, float &_max)
+{
+  std::size_t i = 0;
+#ifdef IGN_GUI_IMAGE_SSE2
+  if (_count >= 4)
+  {
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    __m128 vmin = _mm_set1_ps(_min);
+    __m128 vmax = _mm_set1_ps(_max);
+    for (; i + 4 <= _count; i += 4)
+    {
+      __m128 v = _mm_loadu_ps(reinterpret_cast<const float *>(
+          _data + i * sizeof(float)));
+      // False for infinite and NaN samples, which are replaced by the current
+      // min and max so they don't change them
+      __m128 finite = _mm_cmplt_ps(_mm_and_ps(v, absMask), inf);
+      vmin = _mm_min_ps(vmin, _mm_or_ps(_mm_and_ps(finite, v),
+          _mm_andnot_ps(finite, vmin)));
+      vmax = _mm_max_ps(vmax, _mm_or_ps(_mm_and_ps(finite, v),
+          _mm_andnot_ps(finite, vmax)));
+    }
+    float mins[4];
+    float maxs[4];
+    _mm_storeu_ps(mins, vmin);
+    _mm_storeu_ps(maxs, vmax);
+    for (int k = 0; k < 4; ++k)
+    {
+      _min = std::min(_min, mins[k]);
+      _max = std::max(_max, maxs[k]);
+    }
+  }
+#endif
+  for (; i < _count; ++i)
+  {
+    float d = Sample<float>(_data, i);
+    if (!std::isfinite(d))
+      continue;
+    _min = std::min(_min, d);
+    _max = std::max(_max, d);
+  }
+}
+
+/////////////////////////////////////////////////
+void conversions::MinMax(const unsigned char *_data, std::size_t _count,
+    uint16_t &_min, uint16_t &_max)
+{
+  std::size_t i = 0;
+#ifdef IGN_GUI_IMAGE_SSE2
+  if (_count >= 8)
+  {
+    // SSE2 only compares signed 16-bit integers, flipping the sign bit maps
+    // the unsigned range onto the signed one keeping the order
+    const __m128i sign = _mm_set1_epi16(static_cast<int16_t>(0x8000));
+    __m128i vmin = _mm_xor_si128(_mm_set1_epi16(
+        static_cast<int16_t>(_min)), sign);
+    __m128i vmax = _mm_xor_si128(_mm_set1_epi16(
+        static_cast<int16_t>(_max)), sign);
+    for (; i + 8 <= _count; i += 8)
+    {
+      __m128i v = _mm_xor_si128(_mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(_data + i * sizeof(uint16_t))),
+          sign);
+      vmin = _mm_min_epi16(vmin, v);
+      vmax = _mm_max_epi16(vmax, v);
+    }
+    uint16_t mins[8];
+    uint16_t maxs[8];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(mins),
+        _mm_xor_si128(vmin, sign));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(maxs),
+        _mm_xor_si128(vmax, sign));
+    for (int k = 0; k < 8; ++k)
+    {
+      _min = std::min(_min, mins[k]);
+      _max = std::max(_max, maxs[k]);
+    }
+  }
+#endif
+  for (; i < _count; ++i)
+  {
+    uint16_t d = Sample<uint16_t>(_data, i);
+    _min = std::min(_min, d);
+    _max = std::max(_max, d);
+  }
+}
+
+/////////////////////////////////////////////////
+void conversions::DepthToGray8(const unsigned char *_data, std::size_t _count,
+    float _factor, uint8_t *_out)
+{
+  std::size_t i = 0;
+#ifdef IGN_GUI_IMAGE_SSE2
+  const __m128 factor = _mm_set1_ps(_factor);
+  const __m128 white = _mm_set1_ps(255.0f);
+  const __m128 black = _mm_setzero_ps();
+
+  // Gray values of 4 samples, as 32-bit integers
+  auto gray = [&](std::size_t _i)
+  {
+    __m128 v = _mm_loadu_ps(reinterpret_cast<const float *>(
+        _data + _i * sizeof(float)));
+    v = _mm_sub_ps(white, _mm_mul_ps(v, factor));
+    // min returns its second operand if either is NaN
+    v = _mm_max_ps(_mm_min_ps(v, white), black);
+    return _mm_cvtps_epi32(v);
+  };
+
+  for (; i + 16 <= _count; i += 16)
+  {
+    __m128i lo = _mm_packs_epi32(gray(i), gray(i + 4));
+    __m128i hi = _mm_packs_epi32(gray(i + 8), gray(i + 12));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(_out + i),
+        _mm_packus_epi16(lo, hi));
+  }
+#endif
+  for (; i < _count; ++i)
+    _out[i] = ToGray8(255.0f - Sample<float>(_data, i) * _factor);
+}
+
+/////////////////////////////////////////////////
+void conversions::ScaleToGray8(const unsigned char *_data, std::size_t _count,
+    uint16_t _min, float _scale, uint8_t *_out)
+{
+  std::size_t i = 0;
+#ifdef IGN_GUI_IMAGE_SSE2
+  const __m128i min = _mm_set1_epi16(static_cast<int16_t>(_min));
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 scale = _mm_set1_ps(_scale);
+  const __m128 white = _mm_set1_ps(255.0f);
+
+  // Gray values of 4 samples, given as 32-bit integers
+  auto gray = [&](__m128i _v)
+  {
+    __m128 v = _mm_mul_ps(_mm_cvtepi32_ps(_v), scale);
+    return _mm_cvtps_epi32(_mm_min_ps(v, white));
+  };
+
+  for (; i + 8 <= _count; i += 8)
+  {
+    // Saturates samples below the min to 0
+    __m128i v = _mm_subs_epu16(_mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(_data + i * sizeof(uint16_t))), min);
+    __m128i g = _mm_packs_epi32(gray(_mm_unpacklo_epi16(v, zero)),
+        gray(_mm_unpackhi_epi16(v, zero)));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(_out + i),
+        _mm_packus_epi16(g, g));
+  }
+#endif
+  for (; i < _count; ++i)
+  {
+    uint16_t d = Sample<uint16_t>(_data, i);
+    _out[i] = ToGray8(d > _min ? (d - _min) * _scale : 0.0f);
+  }
+}
+
+/////////////////////////////////////////////////
+void conversions::DemosaicBayer(const int _pattern[2][2],
+    const unsigned char *_data, std::size_t _step, unsigned int _width,
+    unsigned int _height, unsigned char *_out, std::size_t _outStep)
+{
+  // Neighbours past the borders are mirrored, which keeps their colour
+  auto before = [](unsigned int _i, unsigned int _size)
+  {
+    return _i > 0 ? _i - 1 : std::min(_i + 1, _size - 1);
+  };
+  auto after = [](unsigned int _i, unsigned int _size)
+  {
+    return _i + 1 < _size ? _i + 1 : (_i > 0 ? _i - 1 : _i);
+  };
+
+  for (unsigned int j = 0; j < _height; ++j)
+  {
+    const unsigned char *rows[3] = {
+        _data + before(j, _height) * _step,
+        _data + j * _step,
+        _data + after(j, _height) * _step};
+    unsigned char *out = _out + j * _outStep;
+
+    for (unsigned int i = 0; i < _width; ++i)
+    {
+      const unsigned int columns[3] = {before(i, _width), i, after(i, _width)};
+      const int own = _pattern[j & 1][i & 1];
+
+      // Average the neighbours of each missing colour
+      int sums[3] = {0, 0, 0};
+      int counts[3] = {0, 0, 0};
+      for (unsigned int dy = 0; dy < 3; ++dy)
+      {
+        for (unsigned int dx = 0; dx < 3; ++dx)
+        {
+          int color = _pattern[(j + dy + 1) & 1][(i + dx + 1) & 1];
+          if (color == own)
+            continue;
+          sums[color] += rows[dy][columns[dx]];
+          ++counts[color];
+        }
+      }
+
+      for (int c = 0; c < 3; ++c)
+      {
+        if (c == own)
+          out[c] = rows[1][i];
+        else
+          out[c] = counts[c] > 0 ?
+              static_cast<unsigned char>(sums[c] / counts[c]) : 0;
+      }
+      out += 3;
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+bool conversions::ParseColorMap(const std::string &_name, ColorMap &_map)
+{
+  if (_name == "gray")
+    _map = ColorMap::GRAY;
+  else if (_name == "turbo")
+    _map = ColorMap::TURBO;
+  else if (_name == "jet")
+    _map = ColorMap::JET;
+  else
+    return false;
+  return true;
+}
+
+/// \brief Pack a colour with components in [0, 1]
+/// \param[in] _r Red
+/// \param[in] _g Green
+/// \param[in] _b Blue
+/// \return Colour as 0xAARRGGBB
+static uint32_t PackColor(double _r, double _g, double _b)
+{
+  auto component = [](double _c)
+  {
+    return static_cast<uint32_t>(
+        std::lround(255 * std::max(0.0, std::min(1.0, _c))));
+  };
+  return 0xff000000u | (component(_r) << 16) | (component(_g) << 8) |
+      component(_b);
+}
+
+/////////////////////////////////////////////////
+const std::vector<uint32_t> &conversions::ColorTable(ColorMap _map)
+{
+  auto makeTable = [](const std::function<uint32_t(double)> &_color)
+  {
+    std::vector<uint32_t> table(256);
+    for (int i = 0; i < 256; ++i)
+      table[i] = _color(i / 255.0);
+    return table;
+  };
+
+  static const std::vector<uint32_t> gray = makeTable([](double _x)
+  {
+    return PackColor(_x, _x, _x);
+  });
+
+  // Polynomial approximation of Turbo, see
+  // https://ai.googleblog.com/2019/08/turbo-improved-rainbow-colormap-for.html
+  static const std::vector<uint32_t> turbo = makeTable([](double _x)
+  {
+    auto poly = [_x](const double _k[6])
+    {
+      double result = 0;
+      for (int i = 5; i >= 0; --i)
+        result = result * _x + _k[i];
+      return result;
+    };
+    static const double r[6] = {0.13572138, 4.61539260, -42.66032258,
+        132.13108234, -152.94239396, 59.28637943};
+    static const double g[6] = {0.09140261, 2.19418839, 4.84296658,
+        -14.18503333, 4.27729857, 2.82956604};
+    static const double b[6] = {0.10667330, 12.64194608, -60.58204836,
+        110.36276771, -89.90310912, 27.34824973};
+    return PackColor(poly(r), poly(g), poly(b));
+  });
+
+  static const std::vector<uint32_t> jet = makeTable([](double _x)
+  {
+    return PackColor(1.5 - std::abs(4 * _x - 3), 1.5 - std::abs(4 * _x - 2),
+        1.5 - std::abs(4 * _x - 1));
+  });
+
+  switch (_map)
+  {
+    case ColorMap::TURBO:
+      return turbo;
+    case ColorMap::JET:
+      return jet;
+    case ColorMap::GRAY:
+    default:
+      return gray;
+  }
+}
+
+/// \brief Get the converter registry
+/// \return The registry
+static ConverterRegistry &Registry()
+{
+  static ConverterRegistry registry;
+  return registry;
+}
+
+/////////////////////////////////////////////////
+void conversions::RegisterConverter(msgs::PixelFormatType _format,
+    const Converter &_converter)
+{
+  auto &registry = Registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.converters[_format] = _converter;
+}
+
+/////////////////////////////////////////////////
+bool conversions::FindConverter(msgs::PixelFormatType _format,
+    Converter &_converter)
+{
+  auto &registry = Registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto it = registry.converters.find(_format);
+  if (it == registry.converters.end())
+    return false;
+  _converter = it->second;
+  return true;
+}
+
+/// \brief Convert BGR or BGRA to RGB or RGBA
+/// \param[in] _channels Channels per pixel, 3 or 4
+/// \param[in] _data First row of the frame
+/// \param[in] _step Size of an input row in bytes
+/// \param[in] _width Frame width in pixels
+/// \param[in] _height Frame height in pixels
+/// \param[out] _out First row of the output
+/// \param[in] _outStep Size of an output row in bytes
+static void SwapRedBlue(unsigned int _channels, const unsigned char *_data,
+    std::size_t _step, unsigned int _width, unsigned int _height,
+    unsigned char *_out, std::size_t _outStep)
+{
+  for (unsigned int j = 0; j < _height; ++j)
+  {
+    const unsigned char *in = _data + j * _step;
+    unsigned char *out = _out + j * _outStep;
+    std::memcpy(out, in, _width * _channels);
+    for (unsigned int i = 0; i < _width; ++i, out += _channels)
+      std::swap(out[0], out[2]);
+  }
+}
+
+/// \brief Convert 16-bit RGB or BGR to 8-bit RGB, keeping the high byte of
+/// each channel
+/// \param[in] _bgr True if the input is BGR
+/// \param[in] _data First row of the frame
+/// \param[in] _step Size of an input row in bytes
+/// \param[in] _width Frame width in pixels
+/// \param[in] _height Frame height in pixels
+/// \param[out] _out First row of the output
+/// \param[in] _outStep Size of an output row in bytes
+static void Rgb16ToRgb8(bool _bgr, const unsigned char *_data,
+    std::size_t _step, unsigned int _width, unsigned int _height,
+    unsigned char *_out, std::size_t _outStep)
+{
+  for (unsigned int j = 0; j < _height; ++j)
+  {
+    const unsigned char *in = _data + j * _step;
+    unsigned char *out = _out + j * _outStep;
+    for (unsigned int i = 0; i < _width; ++i, out += 3)
+    {
+      for (unsigned int c = 0; c < 3; ++c)
+      {
+        out[_bgr ? 2 - c : c] = static_cast<unsigned char>(
+            Sample<uint16_t>(in, i * 3 + c) >> 8);
+      }
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+ConverterRegistry::ConverterRegistry()
+{
+  using conversions::Converter;
+  using conversions::OutputFormat;
+  using namespace std::placeholders;
+
+  auto add = [this](msgs::PixelFormatType _format, unsigned int _bytes,
+      OutputFormat _output, bool _colorMapped,
+      conversions::ConvertFunction _convert)
+  {
+    Converter converter;
+    converter.bytesPerPixel = _bytes;
+    converter.format = _output;
+    converter.colorMapped = _colorMapped;
+    converter.convert = std::move(_convert);
+    this->converters[_format] = converter;
+  };
+
+  // Displayed as is
+  add(msgs::PixelFormatType::L_INT8, 1, OutputFormat::GRAY8, false, nullptr);
+  add(msgs::PixelFormatType::RGB_INT8, 3, OutputFormat::RGB8, false, nullptr);
+  add(msgs::PixelFormatType::RGBA_INT8, 4, OutputFormat::RGBA8, false,
+      nullptr);
+
+  add(msgs::PixelFormatType::BGR_INT8, 3, OutputFormat::RGB8, false,
+      std::bind(SwapRedBlue, 3, _1, _2, _3, _4, _5, _6));
+  add(msgs::PixelFormatType::BGRA_INT8, 4, OutputFormat::RGBA8, false,
+      std::bind(SwapRedBlue, 4, _1, _2, _3, _4, _5, _6));
+  add(msgs::PixelFormatType::RGB_INT16, 6, OutputFormat::RGB8, false,
+      std::bind(Rgb16ToRgb8, false, _1, _2, _3, _4, _5, _6));
+  add(msgs::PixelFormatType::BGR_INT16, 6, OutputFormat::RGB8, false,
+      std::bind(Rgb16ToRgb8, true, _1, _2, _3, _4, _5, _6));
+
+  // Depth, near samples are bright
+  add(msgs::PixelFormatType::R_FLOAT32, 4, OutputFormat::GRAY8, true,
+      [](const unsigned char *_data, std::size_t _step, unsigned int _width,
+         unsigned int _height, unsigned char *_out, std::size_t _outStep)
+  {
+    float minDepth = std::numeric_limits<float>::max();
+    float maxDepth = 0;
+    for (unsigned int j = 0; j < _height; ++j)
+      conversions::MinMax(_data + j * _step, _width, minDepth, maxDepth);
+
+    float factor = 255 / maxDepth;
+    for (unsigned int j = 0; j < _height; ++j)
+    {
+      conversions::DepthToGray8(_data + j * _step, _width, factor,
+          _out + j * _outStep);
+    }
+  });
+
+  // Temperature, normalised over the frame
+  add(msgs::PixelFormatType::L_INT16, 2, OutputFormat::GRAY8, true,
+      [](const unsigned char *_data, std::size_t _step, unsigned int _width,
+         unsigned int _height, unsigned char *_out, std::size_t _outStep)
+  {
+    uint16_t min = std::numeric_limits<uint16_t>::max();
+    uint16_t max = 0;
+    for (unsigned int j = 0; j < _height; ++j)
+      conversions::MinMax(_data + j * _step, _width, min, max);
+
+    float range = std::max(1.0f, static_cast<float>(max - min));
+    for (unsigned int j = 0; j < _height; ++j)
+    {
+      conversions::ScaleToGray8(_data + j * _step, _width, min, 255 / range,
+          _out + j * _outStep);
+    }
+  });
+
+  // Colours of the top left 2x2 block. BAYER_RGGR8 is BGGR.
+  static const int kRggb[2][2] = {{0, 1}, {1, 2}};
+  static const int kBggr[2][2] = {{2, 1}, {1, 0}};
+  static const int kGbrg[2][2] = {{1, 2}, {0, 1}};
+  static const int kGrbg[2][2] = {{1, 0}, {2, 1}};
+  add(msgs::PixelFormatType::BAYER_RGGB8, 1, OutputFormat::RGB8, false,
+      std::bind(conversions::DemosaicBayer, kRggb, _1, _2, _3, _4, _5, _6));
+  add(msgs::PixelFormatType::BAYER_RGGR8, 1, OutputFormat::RGB8, false,
+      std::bind(conversions::DemosaicBayer, kBggr, _1, _2, _3, _4, _5, _6));
+  add(msgs::PixelFormatType::BAYER_GBRG8, 1, OutputFormat::RGB8, false,
+      std::bind(conversions::DemosaicBayer, kGbrg, _1, _2, _3, _4, _5, _6));
+  add(msgs::PixelFormatType::BAYER_GRBG8, 1, OutputFormat::RGB8, false,
+      std::bind(conversions::DemosaicBayer, kGrbg, _1, _2, _3, _4, _5, _6));
+}
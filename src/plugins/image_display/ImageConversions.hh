@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_GUI_PLUGINS_IMAGECONVERSIONS_HH_
+#define IGNITION_GUI_PLUGINS_IMAGECONVERSIONS_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <ignition/msgs/image.pb.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+namespace ignition
+{
+namespace gui
+{
+namespace plugins
+{
+  /// \brief Pixel conversions of the image display. The kernels work on one
+  /// row of samples at a time, which don't need to be aligned, and use SSE2
+  /// when the target supports it. The converters turn whole frames of a
+  /// pixel format into a displayable format.
+  namespace conversions
+  {
+    /// \brief Displayable formats written by the converters
+    enum class OutputFormat
+    {
+      /// \brief 8-bit gray, 1 byte per pixel
+      GRAY8,
+
+      /// \brief 8-bit RGB, 3 bytes per pixel
+      RGB8,
+
+      /// \brief 8-bit RGBA, 4 bytes per pixel
+      RGBA8
+    };
+
+    /// \brief Colour maps to display normalised gray values
+    enum class ColorMap
+    {
+      /// \brief Plain gray
+      GRAY,
+
+      /// \brief Google's Turbo colour map
+      TURBO,
+
+      /// \brief Jet colour map
+      JET
+    };
+
+    /// \brief Convert all rows of a frame.
+    /// \param[in] _data First row of the frame
+    /// \param[in] _step Size of an input row in bytes
+    /// \param[in] _width Frame width in pixels
+    /// \param[in] _height Frame height in pixels
+    /// \param[out] _out First row of the output
+    /// \param[in] _outStep Size of an output row in bytes
+    using ConvertFunction = std::function<void(const unsigned char *_data,
+        std::size_t _step, unsigned int _width, unsigned int _height,
+        unsigned char *_out, std::size_t _outStep)>;
+
+    /// \brief Converter of a pixel format
+    struct Converter
+    {
+      /// \brief Bytes per pixel of the input, used to validate frames
+      unsigned int bytesPerPixel = 0u;
+
+      /// \brief Format of the output
+      OutputFormat format = OutputFormat::RGB8;
+
+      /// \brief True if the output is gray values normalised over the frame,
+      /// such as depth, which can be displayed through a colour map
+      bool colorMapped = false;
+
+      /// \brief Conversion, null if the input is already in the output
+      /// format and can be displayed as is
+      ConvertFunction convert;
+    };
+
+    /// \brief Register the converter of a pixel format, replacing any
+    /// converter already registered for it.
+    /// \param[in] _format Pixel format
+    /// \param[in] _converter Converter
+    void RegisterConverter(msgs::PixelFormatType _format,
+        const Converter &_converter);
+
+    /// \brief Find the converter of a pixel format
+    /// \param[in] _format Pixel format
+    /// \param[out] _converter Converter of the format
+    /// \return False if the format has no converter
+    bool FindConverter(msgs::PixelFormatType _format, Converter &_converter);
+
+    /// \brief Parse the name of a colour map: "gray", "turbo" or "jet"
+    /// \param[in] _name Name
+    /// \param[out] _map Colour map
+    /// \return False if the name is unknown
+    bool ParseColorMap(const std::string &_name, ColorMap &_map);
+
+    /// \brief Colours of a colour map, indexed by gray value
+    /// \param[in] _map Colour map
+    /// \return 256 colours as 0xAARRGGBB
+    const std::vector<uint32_t> &ColorTable(ColorMap _map);
+
+    /// \brief Update the min and max of float samples, skipping infinite
+    /// and NaN samples.
+    /// \param[in] _data Samples
+    /// \param[in] _count Number of samples
+    /// \param[in,out] _min Minimum, updated with the samples
+    /// \param[in,out] _max Maximum, updated with the samples
+    void MinMax(const unsigned char *_data, std::size_t _count,
+        float &_min, float &_max);
+
+    /// \brief Update the min and max of 16-bit samples.
+    /// \param[in] _data Samples
+    /// \param[in] _count Number of samples
+    /// \param[in,out] _min Minimum, updated with the samples
+    /// \param[in,out] _max Maximum, updated with the samples
+    void MinMax(const unsigned char *_data, std::size_t _count,
+        uint16_t &_min, uint16_t &_max);
+
+    /// \brief Convert depth samples to 8-bit gray, with near samples bright:
+    /// 255 - _d * _factor, clamped to [0, 255] and rounded. NaN samples are
+    /// white.
+    /// \param[in] _data Float samples
+    /// \param[in] _count Number of samples
+    /// \param[in] _factor Scale of the samples
+    /// \param[out] _out Gray values, _count bytes
+    void DepthToGray8(const unsigned char *_data, std::size_t _count,
+        float _factor, uint8_t *_out);
+
+    /// \brief Convert 16-bit samples to 8-bit gray: (_d - _min) * _scale,
+    /// clamped to [0, 255] and rounded.
+    /// \param[in] _data 16-bit samples
+    /// \param[in] _count Number of samples
+    /// \param[in] _min Sample mapped to black
+    /// \param[in] _scale Scale of the samples
+    /// \param[out] _out Gray values, _count bytes
+    void ScaleToGray8(const unsigned char *_data, std::size_t _count,
+        uint16_t _min, float _scale, uint8_t *_out);
+
+    /// \brief Demosaic a Bayer frame into RGB, interpolating the missing
+    /// colours bilinearly.
+    /// \param[in] _pattern Colour of the pixels of the top left 2x2 block,
+    /// indexed by row then column: 0 for red, 1 for green and 2 for blue
+    /// \param[in] _data First row of the frame
+    /// \param[in] _step Size of an input row in bytes
+    /// \param[in] _width Frame width in pixels
+    /// \param[in] _height Frame height in pixels
+    /// \param[out] _out First row of the RGB output
+    /// \param[in] _outStep Size of an output row in bytes
+    void DemosaicBayer(const int _pattern[2][2], const unsigned char *_data,
+        std::size_t _step, unsigned int _width, unsigned int _height,
+        unsigned char *_out, std::size_t _outStep);
+  }
+}
+}
+}
+
+#endif
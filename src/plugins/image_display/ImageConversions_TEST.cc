@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "ImageConversions.hh"
+
+using namespace ignition;
+using namespace gui;
+using namespace plugins;
+
+/// \brief Convert a frame with the converter of a pixel format
+/// \param[in] _format Pixel format
+/// \param[in] _data Frame
+/// \param[in] _step Size of an input row in bytes
+/// \param[in] _width Frame width in pixels
+/// \param[in] _height Frame height in pixels
+/// \param[in] _outChannels Bytes per output pixel
+/// \return Output, with rows of _width * _outChannels bytes
+static std::vector<unsigned char> Convert(msgs::PixelFormatType _format,
+    const std::vector<unsigned char> &_data, std::size_t _step,
+    unsigned int _width, unsigned int _height, unsigned int _outChannels)
+{
+  conversions::Converter converter;
+  EXPECT_TRUE(conversions::FindConverter(_format, converter));
+  EXPECT_TRUE(converter.convert != nullptr);
+  std::vector<unsigned char> out(_width * _height * _outChannels, 0);
+  if (converter.convert)
+  {
+    converter.convert(_data.data(), _step, _width, _height, out.data(),
+        _width * _outChannels);
+  }
+  return out;
+}
+
+/// \brief Bytes of 16-bit samples, in the host byte order
+/// \param[in] _samples Samples
+/// \return Bytes
+static std::vector<unsigned char> Bytes(const std::vector<uint16_t> &_samples)
+{
+  std::vector<unsigned char> bytes(_samples.size() * sizeof(uint16_t));
+  std::memcpy(bytes.data(), _samples.data(), bytes.size());
+  return bytes;
+}
+
+/////////////////////////////////////////////////
+TEST(ImageConversionsTest, Converters)
+{
+  conversions::Converter converter;
+  EXPECT_FALSE(conversions::FindConverter(
+      msgs::PixelFormatType::UNKNOWN_PIXEL_FORMAT, converter));
+
+  // Displayed as is
+  ASSERT_TRUE(conversions::FindConverter(msgs::PixelFormatType::RGB_INT8,
+      converter));
+  EXPECT_EQ(3u, converter.bytesPerPixel);
+  EXPECT_EQ(conversions::OutputFormat::RGB8, converter.format);
+  EXPECT_FALSE(converter.colorMapped);
+  EXPECT_TRUE(converter.convert == nullptr);
+
+  ASSERT_TRUE(conversions::FindConverter(msgs::PixelFormatType::BGRA_INT8,
+      converter));
+  EXPECT_EQ(4u, converter.bytesPerPixel);
+  EXPECT_EQ(conversions::OutputFormat::RGBA8, converter.format);
+
+  ASSERT_TRUE(conversions::FindConverter(msgs::PixelFormatType::RGB_INT16,
+      converter));
+  EXPECT_EQ(6u, converter.bytesPerPixel);
+  EXPECT_EQ(conversions::OutputFormat::RGB8, converter.format);
+
+  ASSERT_TRUE(conversions::FindConverter(msgs::PixelFormatType::BAYER_RGGB8,
+      converter));
+  EXPECT_EQ(1u, converter.bytesPerPixel);
+  EXPECT_EQ(conversions::OutputFormat::RGB8, converter.format);
+
+  ASSERT_TRUE(conversions::FindConverter(msgs::PixelFormatType::R_FLOAT32,
+      converter));
+  EXPECT_EQ(conversions::OutputFormat::GRAY8, converter.format);
+  EXPECT_TRUE(converter.colorMapped);
+}
+
+/////////////////////////////////////////////////
+TEST(ImageConversionsTest, SwapRedBlue)
+{
+  // 2x2 frames, with rows padded to 8 bytes
+  std::vector<unsigned char> bgr = {
+      1, 2, 3, 4, 5, 6, 0, 0,
+      7, 8, 9, 10, 11, 12, 0, 0};
+  EXPECT_EQ(std::vector<unsigned char>({
+      3, 2, 1, 6, 5, 4,
+      9, 8, 7, 12, 11, 10}),
+      Convert(msgs::PixelFormatType::BGR_INT8, bgr, 8, 2, 2, 3));
+
+  std::vector<unsigned char> bgra = {
+      1, 2, 3, 255, 4, 5, 6, 128,
+      7, 8, 9, 0, 10, 11, 12, 64};
+  EXPECT_EQ(std::vector<unsigned char>({
+      3, 2, 1, 255, 6, 5, 4, 128,
+      9, 8, 7, 0, 12, 11, 10, 64}),
+      Convert(msgs::PixelFormatType::BGRA_INT8, bgra, 8, 2, 2, 4));
+}
+
+/////////////////////////////////////////////////
+TEST(ImageConversionsTest, Rgb16)
+{
+  // 2x1 frame, the high byte of each channel is kept
+  auto rgb = Bytes({0x1234, 0xff00, 0x0100, 0x00ff, 0x8080, 0xfedc});
+  EXPECT_EQ(std::vector<unsigned char>({0x12, 0xff, 0x01, 0x00, 0x80, 0xfe}),
+      Convert(msgs::PixelFormatType::RGB_INT16, rgb, 12, 2, 1, 3));
+
+  EXPECT_EQ(std::vector<unsigned char>({0x01, 0xff, 0x12, 0xfe, 0x80, 0x00}),
+      Convert(msgs::PixelFormatType::BGR_INT16, rgb, 12, 2, 1, 3));
+}
+
+/////////////////////////////////////////////////
+TEST(ImageConversionsTest, Bayer)
+{
+  // 4x4 frame whose samples go from 10 to 160, row by row
+  std::vector<unsigned char> raw(16);
+  for (unsigned int i = 0; i < raw.size(); ++i)
+    raw[i] = static_cast<unsigned char>(10 * (i + 1));
+
+  // The missing colours are the average of the neighbours of that colour,
+  // mirrored past the borders
+  EXPECT_EQ(std::vector<unsigned char>({
+      10, 35, 60, 20, 20, 60, 30, 50, 70, 30, 40, 80,
+      50, 50, 60, 60, 60, 60, 70, 70, 70, 70, 75, 80,
+      90, 95, 100, 100, 100, 100, 110, 110, 110, 110, 120, 120,
+      90, 130, 140, 100, 120, 140, 110, 150, 150, 110, 135, 160}),
+      Convert(msgs::PixelFormatType::BAYER_RGGB8, raw, 4, 4, 4, 3));
+
+  // BAYER_RGGR8 is BGGR
+  EXPECT_EQ(std::vector<unsigned char>({
+      60, 35, 10, 60, 20, 20, 70, 50, 30, 80, 40, 30,
+      60, 50, 50, 60, 60, 60, 70, 70, 70, 80, 75, 70,
+      100, 95, 90, 100, 100, 100, 110, 110, 110, 120, 120, 110,
+      140, 130, 90, 140, 120, 100, 150, 150, 110, 160, 135, 110}),
+      Convert(msgs::PixelFormatType::BAYER_RGGR8, raw, 4, 4, 4, 3));
+
+  EXPECT_EQ(std::vector<unsigned char>({
+      50, 10, 20, 60, 40, 20, 70, 30, 30, 70, 55, 40,
+      50, 55, 60, 60, 60, 60, 70, 70, 70, 70, 80, 80,
+      90, 90, 100, 100, 100, 100, 110, 110, 110, 110, 115, 120,
+      130, 115, 100, 140, 140, 100, 150, 130, 110, 150, 160, 120}),
+      Convert(msgs::PixelFormatType::BAYER_GBRG8, raw, 4, 4, 4, 3));
+
+  EXPECT_EQ(std::vector<unsigned char>({
+      20, 10, 50, 20, 40, 60, 30, 30, 70, 40, 55, 70,
+      60, 55, 50, 60, 60, 60, 70, 70, 70, 80, 80, 70,
+      100, 90, 90, 100, 100, 100, 110, 110, 110, 120, 115, 110,
+      100, 115, 130, 100, 140, 140, 110, 130, 150, 120, 160, 150}),
+      Convert(msgs::PixelFormatType::BAYER_GRBG8, raw, 4, 4, 4, 3));
+
+  // A uniform colour is kept everywhere
+  const unsigned char colors[3] = {200, 100, 50};
+  const int rggb[2][2] = {{0, 1}, {1, 2}};
+  for (unsigned int j = 0; j < 4; ++j)
+  {
+    for (unsigned int i = 0; i < 4; ++i)
+      raw[j * 4 + i] = colors[rggb[j & 1][i & 1]];
+  }
+  auto rgb = Convert(msgs::PixelFormatType::BAYER_RGGB8, raw, 4, 4, 4, 3);
+  for (unsigned int i = 0; i < rgb.size(); ++i)
+    EXPECT_EQ(colors[i % 3], rgb[i]) << "byte " << i;
+}
+
+/////////////////////////////////////////////////
+TEST(ImageConversionsTest, ColorTables)
+{
+  conversions::ColorMap map = conversions::ColorMap::GRAY;
+  EXPECT_TRUE(conversions::ParseColorMap("turbo", map));
+  EXPECT_EQ(conversions::ColorMap::TURBO, map);
+  EXPECT_TRUE(conversions::ParseColorMap("jet", map));
+  EXPECT_EQ(conversions::ColorMap::JET, map);
+  EXPECT_TRUE(conversions::ParseColorMap("gray", map));
+  EXPECT_EQ(conversions::ColorMap::GRAY, map);
+  EXPECT_FALSE(conversions::ParseColorMap("viridis", map));
+  EXPECT_EQ(conversions::ColorMap::GRAY, map);
+
+  const auto &gray = conversions::ColorTable(conversions::ColorMap::GRAY);
+  ASSERT_EQ(256u, gray.size());
+  EXPECT_EQ(0xff000000u, gray[0]);
+  EXPECT_EQ(0xff808080u, gray[128]);
+  EXPECT_EQ(0xffffffffu, gray[255]);
+
+  const auto &turbo = conversions::ColorTable(conversions::ColorMap::TURBO);
+  ASSERT_EQ(256u, turbo.size());
+  EXPECT_EQ(0xff23171bu, turbo[0]);
+  EXPECT_EQ(0xff98fa4fu, turbo[128]);
+  EXPECT_EQ(0xff900d00u, turbo[255]);
+
+  const auto &jet = conversions::ColorTable(conversions::ColorMap::JET);
+  ASSERT_EQ(256u, jet.size());
+  EXPECT_EQ(0xff000080u, jet[0]);
+  EXPECT_EQ(0xff82ff7eu, jet[128]);
+  EXPECT_EQ(0xff800000u, jet[255]);
+}
@@ -15,15 +15,21 @@
  *
 */
 
-#include <QQuickImageProvider>
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
 
 #include <ignition/common/Console.hh>
 #include <ignition/common/Image.hh>
 #include <ignition/plugin/Register.hh>
 #include <ignition/transport/Node.hh>
 
-#include "ignition/gui/Application.hh"
+#include "FrameMailbox.hh"
+#include "ImageConversions.hh"
 #include "ImageDisplay.hh"
 
 namespace ignition
@@ -32,73 +38,177 @@ namespace gui
 {
 namespace plugins
 {
-  class ImageProvider : public QQuickImageProvider
+  /// \brief Image received on the transport thread. The pixels are copied
+  /// once out of the message into a buffer which is shared with the QImage
+  /// displaying them.
+  struct ImageFrame
   {
-    public: ImageProvider()
-       : QQuickImageProvider(QQuickImageProvider::Image)
-    {
-    }
+    /// \brief Image width in pixels
+    unsigned int width = 0u;
 
-    public: QImage requestImage(const QString &, QSize *,
-        const QSize &) override
-    {
-      if (!this->img.isNull())
-      {
-        // Must return a copy
-        QImage copy(this->img);
-        return copy;
-      }
+    /// \brief Image height in pixels
+    unsigned int height = 0u;
 
-      // Placeholder in case we have no image yet
-      QImage i(400, 400, QImage::Format_RGB888);
-      i.fill(QColor(128, 128, 128, 100));
-      return i;
-    }
+    /// \brief Size of a row in bytes, 0 if the message didn't set it
+    unsigned int step = 0u;
 
-    public: void SetImage(const QImage &_image)
-    {
-      this->img = _image;
-    }
+    /// \brief Pixel format
+    msgs::PixelFormatType format = msgs::PixelFormatType::UNKNOWN_PIXEL_FORMAT;
+
+    /// \brief Pixels
+    std::shared_ptr<const std::string> data;
+  };
+
+  class ImageItemPrivate
+  {
+    /// \brief Latest image, not uploaded yet. The scene graph reads it in
+    /// updatePaintNode, while the GUI thread is blocked.
+    public: QImage image;
+
+    /// \brief True if the image changed since the last upload
+    public: bool dirty = false;
+
+    /// \brief GL texture the images are uploaded to, owned by the texture
+    /// of the node. 0 until the node has a texture.
+    public: GLuint textureId = 0;
 
-    private: QImage img;
+    /// \brief Size of the GL texture
+    public: QSize textureSize;
+
+    /// \brief Pixel format of the GL texture, GL_RGB or GL_RGBA
+    public: GLenum textureFormat = GL_RGBA;
   };
 
   class ImageDisplayPrivate
   {
+    /// \brief Convert frames until stopped, always taking the latest one.
+    /// Runs on its own thread.
+    /// \param[in] _display Plugin displaying the converted images
+    public: void RunConvertThread(ImageDisplay *_display);
+
+    /// \brief Convert a frame into a displayable image
+    /// \param[in] _frame Frame
+    /// \param[out] _image Converted image
+    /// \return False if the frame can't be converted
+    public: bool Convert(const ImageFrame &_frame, QImage &_image);
+
+    /// \brief Get the image to convert a frame into. The image of the
+    /// previous frame is reused once the display released it.
+    /// \param[in] _width Image width in pixels
+    /// \param[in] _height Image height in pixels
+    /// \param[in] _format Image format
+    /// \return Image of the given size and format
+    public: QImage &OutputImage(unsigned int _width, unsigned int _height,
+        QImage::Format _format);
+
     /// \brief List of topics publishing image messages.
     public: QStringList topicList;
 
-    /// \brief Holds data to set as the next image
-    public: msgs::Image imageMsg;
+    /// \brief Latest image received, waiting to be converted. A newer image
+    /// replaces it.
+    public: FrameMailbox<ImageFrame> frames;
 
-    /// \brief Node for communication.
-    public: transport::Node node;
+    /// \brief Latest converted image, waiting to be displayed
+    public: QImage convertedImage;
+
+    /// \brief True if an image is waiting to be displayed
+    public: bool imageReady = false;
 
-    /// \brief Mutex for accessing image data
-    public: std::recursive_mutex imageMutex;
+    /// \brief True if the main thread is scheduled to display the latest
+    /// image
+    public: bool displayScheduled = false;
 
-    /// \brief To provide images for QML.
-    public: ImageProvider *provider{nullptr};
+    /// \brief Mutex for accessing the converted image
+    public: std::mutex imageMutex;
+
+    /// \brief Thread converting the frames
+    public: std::thread convertThread;
+
+    /// \brief Number of frames converted
+    public: std::atomic<int> convertedFrames{0};
+
+    /// \brief Item displaying the images.
+    public: ImageItem *imageItem{nullptr};
+
+    /// \brief Output of the conversions, only used by the conversion thread
+    public: QImage outputImage;
+
+    /// \brief Colour map of normalised images, such as depth
+    public: conversions::ColorMap colorMap = conversions::ColorMap::GRAY;
+
+    /// \brief Colours of the colour map
+    public: QVector<QRgb> colorTable;
+
+    /// \brief Node for communication. Last, so it's destroyed first and
+    /// no callback uses the members destroyed before it.
+    public: transport::Node node;
   };
 }
 }
 }
 
+/// \brief Release the reference a QImage holds on the pixels of a frame
+/// \param[in] _info Pointer to the shared pointer to the pixels
+static void ReleaseFrameData(void *_info)
+{
+  delete static_cast<std::shared_ptr<const std::string> *>(_info);
+}
+
 using namespace ignition;
 using namespace gui;
 using namespace plugins;
 
+/// \brief Get the Qt format of a converter output
+/// \param[in] _format Converter output
+/// \return Qt format
+static QImage::Format QtFormat(conversions::OutputFormat _format)
+{
+  switch (_format)
+  {
+    case conversions::OutputFormat::GRAY8:
+      return QImage::Format_Grayscale8;
+    case conversions::OutputFormat::RGBA8:
+      return QImage::Format_RGBA8888;
+    case conversions::OutputFormat::RGB8:
+    default:
+      return QImage::Format_RGB888;
+  }
+}
+
+/////////////////////////////////////////////////
+QImage &ImageDisplayPrivate::OutputImage(unsigned int _width,
+    unsigned int _height, QImage::Format _format)
+{
+  // Only write into the pixels if nobody else holds them, the texture may
+  // still be uploading the previous frame
+  if (!this->outputImage.isDetached() ||
+      this->outputImage.format() != _format ||
+      this->outputImage.width() != static_cast<int>(_width) ||
+      this->outputImage.height() != static_cast<int>(_height))
+  {
+    this->outputImage = QImage(_width, _height, _format);
+  }
+  return this->outputImage;
+}
+
 /////////////////////////////////////////////////
 ImageDisplay::ImageDisplay()
   : Plugin(), dataPtr(new ImageDisplayPrivate)
 {
+  qmlRegisterType<ImageItem>("ImageDisplay", 1, 0, "ImageItem");
 }
 
 /////////////////////////////////////////////////
 ImageDisplay::~ImageDisplay()
 {
-  App()->Engine()->removeImageProvider(
-      this->CardItem()->objectName() + "imagedisplay");
+  // no more frames while the conversion thread stops
+  for (const auto &topic : this->dataPtr->node.SubscribedTopics())
+    this->dataPtr->node.Unsubscribe(topic);
+
+  this->dataPtr->frames.Stop();
+
+  if (this->dataPtr->convertThread.joinable())
+    this->dataPtr->convertThread.join();
 }
 
 /////////////////////////////////////////////////
@@ -119,6 +229,24 @@ void ImageDisplay::LoadConfig(const tinyxml2::XMLElement *_pluginElem)
 
     if (auto pickerElem = _pluginElem->FirstChildElement("topic_picker"))
       pickerElem->QueryBoolText(&topicPicker);
+
+    auto elem = _pluginElem->FirstChildElement("color_map");
+    if (nullptr != elem && nullptr != elem->GetText() &&
+        !conversions::ParseColorMap(elem->GetText(), this->dataPtr->colorMap))
+    {
+      ignwarn << "Unknown color map [" << elem->GetText()
+              << "], using gray." << std::endl;
+    }
+  }
+
+  for (auto color : conversions::ColorTable(this->dataPtr->colorMap))
+    this->dataPtr->colorTable.push_back(color);
+
+  // Frames are converted off the main thread, which only displays them
+  if (!this->dataPtr->convertThread.joinable())
+  {
+    this->dataPtr->convertThread = std::thread(
+        &ImageDisplayPrivate::RunConvertThread, this->dataPtr.get(), this);
   }
 
   if (topic.empty() && !topicPicker)
@@ -134,42 +262,128 @@ void ImageDisplay::LoadConfig(const tinyxml2::XMLElement *_pluginElem)
   else
     this->OnRefresh();
 
-  this->dataPtr->provider = new ImageProvider();
-  App()->Engine()->addImageProvider(
-      this->CardItem()->objectName() + "imagedisplay", this->dataPtr->provider);
+  this->dataPtr->imageItem = this->PluginItem()->findChild<ImageItem *>();
+  if (!this->dataPtr->imageItem)
+  {
+    ignerr << "Unable to find image item. Images will not be displayed."
+           << std::endl;
+  }
 }
 
 /////////////////////////////////////////////////
-void ImageDisplay::ProcessImage()
+void ImageDisplayPrivate::RunConvertThread(ImageDisplay *_display)
 {
-  std::lock_guard<std::recursive_mutex> lock(this->dataPtr->imageMutex);
-  switch (this->dataPtr->imageMsg.pixel_format_type())
+  while (true)
   {
-    case msgs::PixelFormatType::RGB_INT8:
-      this->UpdateFromRgbInt8();
-      break;
-    case msgs::PixelFormatType::R_FLOAT32:
-      this->UpdateFromFloat32();
-      break;
-    case msgs::PixelFormatType::L_INT16:
-      this->UpdateFromLInt16();
-      break;
-    default:
+    ImageFrame frame;
+    if (!this->frames.Take(frame))
+      return;
+
+    QImage image;
+    bool converted = this->Convert(frame, image);
+    if (converted)
+      ++this->convertedFrames;
+
+    bool scheduled;
     {
-      ignwarn << "Unsupported image type: "
-              << this->dataPtr->imageMsg.pixel_format_type() << std::endl;
+      std::lock_guard<std::mutex> lock(this->imageMutex);
+      if (converted)
+      {
+        std::swap(this->convertedImage, image);
+        this->imageReady = true;
+      }
+      scheduled = this->displayScheduled;
+      this->displayScheduled = true;
     }
+
+    // Signal to main thread that the image changed, unless it's already
+    // scheduled to display the latest image
+    if (!scheduled)
+      QMetaObject::invokeMethod(_display, "DisplayImage");
   }
 }
 
 /////////////////////////////////////////////////
-void ImageDisplay::OnImageMsg(const msgs::Image &_msg)
+bool ImageDisplayPrivate::Convert(const ImageFrame &_frame, QImage &_image)
 {
-  std::lock_guard<std::recursive_mutex> lock(this->dataPtr->imageMutex);
-  this->dataPtr->imageMsg = _msg;
+  conversions::Converter converter;
+  if (!conversions::FindConverter(_frame.format, converter))
+  {
+    ignwarn << "Unsupported image type: " << _frame.format << std::endl;
+    return false;
+  }
+
+  auto step = _frame.step > 0 ? _frame.step : _frame.width *
+      converter.bytesPerPixel;
+  if (_frame.width == 0 || _frame.height == 0 ||
+      step < _frame.width * converter.bytesPerPixel ||
+      _frame.data->size() < static_cast<std::size_t>(step) * _frame.height)
+  {
+    ignerr << "Image data size [" << _frame.data->size()
+           << "] doesn't match its dimensions [" << _frame.width << " x "
+           << _frame.height << "]" << std::endl;
+    return false;
+  }
+
+  auto data = reinterpret_cast<const unsigned char *>(_frame.data->data());
+  auto format = QtFormat(converter.format);
+  if (!converter.convert)
+  {
+    // Display the pixels in place, the image keeps them alive
+    _image = QImage(data, _frame.width, _frame.height, step, format,
+        ReleaseFrameData, new std::shared_ptr<const std::string>(_frame.data));
+    return true;
+  }
+
+  // Gray values are indices into the colour map
+  bool mapped = converter.colorMapped &&
+      this->colorMap != conversions::ColorMap::GRAY;
+  if (mapped)
+    format = QImage::Format_Indexed8;
 
-  // Signal to main thread that the image changed
-  QMetaObject::invokeMethod(this, "ProcessImage");
+  QImage &image = this->OutputImage(_frame.width, _frame.height, format);
+  converter.convert(data, step, _frame.width, _frame.height, image.bits(),
+      image.bytesPerLine());
+
+  if (mapped)
+    image.setColorTable(this->colorTable);
+
+  _image = image;
+  return true;
+}
+
+/////////////////////////////////////////////////
+void ImageDisplay::DisplayImage()
+{
+  QImage image;
+  bool ready;
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->imageMutex);
+    std::swap(image, this->dataPtr->convertedImage);
+    ready = this->dataPtr->imageReady;
+    this->dataPtr->imageReady = false;
+    this->dataPtr->displayScheduled = false;
+  }
+
+  if (ready)
+    this->SetImage(image);
+
+  this->FrameCountsChanged();
+}
+
+/////////////////////////////////////////////////
+void ImageDisplay::OnImageMsg(const msgs::Image &_msg)
+{
+  // The only copy of the pixels, made outside the lock
+  ImageFrame frame;
+  frame.width = _msg.width();
+  frame.height = _msg.height();
+  frame.step = _msg.step();
+  frame.format = _msg.pixel_format_type();
+  frame.data = std::make_shared<const std::string>(_msg.data());
+
+  // Only the latest frame is converted
+  this->dataPtr->frames.Post(std::move(frame));
 }
 
 /////////////////////////////////////////////////
@@ -222,128 +436,167 @@ void ImageDisplay::OnRefresh()
 }
 
 /////////////////////////////////////////////////
-void ImageDisplay::UpdateFromRgbInt8()
+void ImageDisplay::SetImage(const QImage &_image)
 {
-  QImage image(
-    reinterpret_cast<const uchar *>(this->dataPtr->imageMsg.data().c_str()),
-    this->dataPtr->imageMsg.width(), this->dataPtr->imageMsg.height(),
-    QImage::Format_RGB888);
+  if (!this->dataPtr->imageItem)
+    return;
 
-  this->dataPtr->provider->SetImage(image);
+  this->dataPtr->imageItem->SetImage(_image);
   this->newImage();
 }
 
 /////////////////////////////////////////////////
-void ImageDisplay::UpdateFromFloat32()
+QStringList ImageDisplay::TopicList() const
 {
-  unsigned int height = this->dataPtr->imageMsg.height();
-  unsigned int width = this->dataPtr->imageMsg.width();
-  QImage::Format qFormat = QImage::Format_RGB888;
-
-  QImage image = QImage(width, height, qFormat);
+  return this->dataPtr->topicList;
+}
 
-  unsigned int depthSamples = width * height;
-  float f;
-  // cppchecker recommends using sizeof(varname)
-  unsigned int depthBufferSize = depthSamples * sizeof(f);
+/////////////////////////////////////////////////
+void ImageDisplay::SetTopicList(const QStringList &_topicList)
+{
+  this->dataPtr->topicList = _topicList;
+  this->TopicListChanged();
+}
 
-  float * depthBuffer = new float[depthSamples];
+/////////////////////////////////////////////////
+int ImageDisplay::ReceivedFrames() const
+{
+  return this->dataPtr->frames.Received();
+}
 
-  memcpy(depthBuffer, this->dataPtr->imageMsg.data().c_str(),
-      depthBufferSize);
+/////////////////////////////////////////////////
+int ImageDisplay::ConvertedFrames() const
+{
+  return this->dataPtr->convertedFrames;
+}
 
-  float maxDepth = 0;
-  for (unsigned int i = 0; i < depthSamples; ++i)
-  {
-    if (depthBuffer[i] > maxDepth && !std::isinf(depthBuffer[i]))
-    {
-      maxDepth = depthBuffer[i];
-    }
-  }
-  unsigned int idx = 0;
-  double factor = 255 / maxDepth;
-  for (unsigned int j = 0; j < height; ++j)
-  {
-    for (unsigned int i = 0; i < width; ++i)
-    {
-      float d = depthBuffer[idx++];
-      d = 255 - (d * factor);
-      QRgb value = qRgb(d, d, d);
-      image.setPixel(i, j, value);
-    }
-  }
+/////////////////////////////////////////////////
+int ImageDisplay::DroppedFrames() const
+{
+  return this->dataPtr->frames.Dropped();
+}
 
-  this->dataPtr->provider->SetImage(image);
-  this->newImage();
+/////////////////////////////////////////////////
+ImageItem::ImageItem(QQuickItem *_parent)
+  : QQuickItem(_parent), dataPtr(new ImageItemPrivate)
+{
+  this->setFlag(ItemHasContents);
 
-  delete[] depthBuffer;
+  // Fit the image to the new size
+  this->connect(this, &QQuickItem::widthChanged, this, &QQuickItem::update);
+  this->connect(this, &QQuickItem::heightChanged, this, &QQuickItem::update);
 }
 
 /////////////////////////////////////////////////
-void ImageDisplay::UpdateFromLInt16()
+ImageItem::~ImageItem()
 {
-  unsigned int height = this->dataPtr->imageMsg.height();
-  unsigned int width = this->dataPtr->imageMsg.width();
-  QImage::Format qFormat = QImage::Format_RGB888;
+}
 
-  QImage image = QImage(width, height, qFormat);
+/////////////////////////////////////////////////
+void ImageItem::SetImage(const QImage &_image)
+{
+  // Only the latest image is uploaded
+  this->dataPtr->image = _image;
+  this->dataPtr->dirty = true;
+  this->update();
+}
 
-  unsigned int samples = width * height;
-  uint16_t type;
-  // cppchecker recommends using sizeof(varname)
-  unsigned int bufferSize = samples * sizeof(type);
+/////////////////////////////////////////////////
+QSGNode *ImageItem::updatePaintNode(QSGNode *_oldNode,
+    QQuickItem::UpdatePaintNodeData * /*_data*/)
+{
+  auto node = static_cast<QSGSimpleTextureNode *>(_oldNode);
 
-  uint16_t *buffer = new uint16_t[samples];
-  memcpy(buffer, this->dataPtr->imageMsg.data().c_str(),
-      bufferSize);
+  // The GL texture went away with the previous node
+  if (!node)
+    this->dataPtr->textureId = 0;
 
-  // get min and max of temperature values
-  uint16_t min = std::numeric_limits<uint16_t>::max();
-  uint16_t max = 0;
-  for (unsigned int i = 0; i < samples; ++i)
+  if (this->dataPtr->dirty && !this->dataPtr->image.isNull())
   {
-    uint16_t temp = buffer[i];
-    if (temp > max)
-      max = temp;
-    if (temp < min)
-      min = temp;
-  }
+    // Upload RGB rows as they are, and the other formats as premultiplied
+    // RGBA, like createTextureFromImage does
+    QImage image = this->dataPtr->image;
+    GLenum format = GL_RGB;
+    int bytesPerPixel = 3;
+    if (image.format() != QImage::Format_RGB888)
+    {
+      if (image.format() != QImage::Format_RGBA8888_Premultiplied)
+        image = image.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
+      format = GL_RGBA;
+      bytesPerPixel = 4;
+    }
 
-  // convert temperature to grayscale image
-  double range = static_cast<double>(max - min);
-  if (ignition::math::equal(range, 0.0))
-    range = 1.0;
-  unsigned int idx = 0;
-  for (unsigned int j = 0; j < height; ++j)
-  {
-    for (unsigned int i = 0; i < width; ++i)
+    // GL only skips the padding of rows aligned to 4 bytes, such as the
+    // rows of the images Qt allocates, so other rows are packed first
+    int rowBytes = image.width() * bytesPerPixel;
+    int alignment = 4;
+    if (image.bytesPerLine() == rowBytes)
+      alignment = 1;
+    else if (image.bytesPerLine() != (rowBytes + 3) / 4 * 4)
+      image = image.copy();
+
+    auto gl = QOpenGLContext::currentContext()->functions();
+    gl->glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+
+    if (this->dataPtr->textureId != 0 &&
+        this->dataPtr->textureSize == image.size() &&
+        this->dataPtr->textureFormat == format)
     {
-      uint16_t temp = buffer[idx++];
-      double t = static_cast<double>(temp-min) / range;
-      int r = 255*t;
-      int g = r;
-      int b = r;
-      QRgb value = qRgb(r, g, b);
-      image.setPixel(i, j, value);
+      // Same size and format, only the pixels change
+      gl->glBindTexture(GL_TEXTURE_2D, this->dataPtr->textureId);
+      gl->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width(),
+          image.height(), format, GL_UNSIGNED_BYTE, image.constBits());
+      node->markDirty(QSGNode::DirtyMaterial);
     }
+    else
+    {
+      GLuint id = 0;
+      gl->glGenTextures(1, &id);
+      gl->glBindTexture(GL_TEXTURE_2D, id);
+      gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      gl->glTexImage2D(GL_TEXTURE_2D, 0, format, image.width(),
+          image.height(), 0, format, GL_UNSIGNED_BYTE, image.constBits());
+
+      QQuickWindow::CreateTextureOptions options =
+          QQuickWindow::TextureOwnsGLTexture;
+      if (this->dataPtr->image.hasAlphaChannel())
+        options |= QQuickWindow::TextureHasAlphaChannel;
+      auto texture = this->window()->createTextureFromId(id, image.size(),
+          options);
+
+      if (!node)
+      {
+        node = new QSGSimpleTextureNode();
+        node->setOwnsTexture(true);
+        node->setFiltering(QSGTexture::Linear);
+      }
+      // The previous texture, and its GL texture, are deleted by the node
+      node->setTexture(texture);
+
+      this->dataPtr->textureId = id;
+      this->dataPtr->textureSize = image.size();
+      this->dataPtr->textureFormat = format;
+    }
+
+    gl->glBindTexture(GL_TEXTURE_2D, 0);
+    gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // Release the pixels, they're on the GPU now
+    this->dataPtr->image = QImage();
+    this->dataPtr->dirty = false;
   }
-  this->dataPtr->provider->SetImage(image);
-  this->newImage();
 
-  delete[] buffer;
-}
+  if (!node)
+    return nullptr;
 
-/////////////////////////////////////////////////
-QStringList ImageDisplay::TopicList() const
-{
-  return this->dataPtr->topicList;
-}
+  // Keep the aspect ratio, aligned to the top
+  QSizeF size = QSizeF(node->texture()->textureSize()).scaled(
+      this->boundingRect().size(), Qt::KeepAspectRatio);
+  node->setRect(QRectF((this->width() - size.width()) * 0.5, 0,
+      size.width(), size.height()));
 
-/////////////////////////////////////////////////
-void ImageDisplay::SetTopicList(const QStringList &_topicList)
-{
-  this->dataPtr->topicList = _topicList;
-  this->TopicListChanged();
+  return node;
 }
 
 // Register this plugin
@@ -36,14 +36,22 @@ namespace gui
 namespace plugins
 {
   class ImageDisplayPrivate;
+  class ImageItemPrivate;
 
   /// \brief Display images coming through an Ignition transport topic.
+  /// Frames are converted on a separate thread, which only converts the
+  /// latest frame received. Older frames are dropped.
   ///
   /// ## Configuration
   ///
   /// \<topic\> : Set the topic to receive image messages.
   /// \<topic_picker\> : Whether to show the topic picker, true by default. If
   ///                    this is false, a \<topic\> must be specified.
+  /// \<color_map\> : Colour map of depth and 16-bit images: "gray", "turbo"
+  ///                 or "jet". Defaults to "gray".
+  ///
+  /// Pixel formats are converted by the converters registered with
+  /// conversions::RegisterConverter, see ImageConversions.hh.
   class ImageDisplay : public Plugin
   {
     Q_OBJECT
@@ -56,6 +64,28 @@ namespace plugins
       NOTIFY TopicListChanged
     )
 
+    /// \brief Number of frames received
+    Q_PROPERTY(
+      int receivedFrames
+      READ ReceivedFrames
+      NOTIFY FrameCountsChanged
+    )
+
+    /// \brief Number of frames converted for display
+    Q_PROPERTY(
+      int convertedFrames
+      READ ConvertedFrames
+      NOTIFY FrameCountsChanged
+    )
+
+    /// \brief Number of frames dropped because a newer frame arrived before
+    /// they were converted
+    Q_PROPERTY(
+      int droppedFrames
+      READ DroppedFrames
+      NOTIFY FrameCountsChanged
+    )
+
     /// \brief Constructor
     public: ImageDisplay();
 
@@ -81,23 +111,34 @@ namespace plugins
     /// \param[in] _topicList Message type
     public: Q_INVOKABLE void SetTopicList(const QStringList &_topicList);
 
+    /// \brief Get the number of frames received
+    /// \return Number of frames
+    public: Q_INVOKABLE int ReceivedFrames() const;
+
+    /// \brief Get the number of frames converted for display
+    /// \return Number of frames
+    public: Q_INVOKABLE int ConvertedFrames() const;
+
+    /// \brief Get the number of frames dropped because a newer frame arrived
+    /// before they were converted
+    /// \return Number of frames
+    public: Q_INVOKABLE int DroppedFrames() const;
+
     /// \brief Notify that topic list has changed
     signals: void TopicListChanged();
 
-    /// \brief Notify that a new image has been received.
-    signals: void newImage();
-
-    /// \brief Callback in main thread when image changes
-    private slots: void ProcessImage();
+    /// \brief Notify that the frame counts have changed
+    signals: void FrameCountsChanged();
 
-    /// \brief Update from rx'd RGB_INT8
-    private: void UpdateFromRgbInt8();
+    /// \brief Notify that a new image has been displayed.
+    signals: void newImage();
 
-    /// \brief Update from rx'd R_FLOAT32
-    private: void UpdateFromFloat32();
+    /// \brief Callback in main thread to display the latest converted image
+    private slots: void DisplayImage();
 
-    /// \brief Update from L_INT16
-    private: void UpdateFromLInt16();
+    /// \brief Display an image
+    /// \param[in] _image Image
+    private: void SetImage(const QImage &_image);
 
     /// \brief Subscriber callback when new image is received
     /// \param[in] _msg New image
@@ -107,6 +148,39 @@ namespace plugins
     /// \brief Pointer to private data.
     private: std::unique_ptr<ImageDisplayPrivate> dataPtr;
   };
+
+  /// \brief Item displaying the latest image as a texture, scaled to fit
+  /// the item. The image is uploaded once per frame of the scene graph, so
+  /// images set between two frames are dropped. The texture is updated in
+  /// place while the image size and format don't change.
+  class ImageItem : public QQuickItem
+  {
+    Q_OBJECT
+
+    /// \brief Constructor
+    /// \param[in] _parent Parent item
+    public: explicit ImageItem(QQuickItem *_parent = nullptr);
+
+    /// \brief Destructor
+    public: ~ImageItem() override;
+
+    /// \brief Set the image to display on the next frame. Must be called
+    /// from the GUI thread.
+    /// \param[in] _image Image
+    public: void SetImage(const QImage &_image);
+
+    /// \brief Upload the latest image to a texture
+    /// \param[in] _oldNode The node passed in previous updatePaintNode
+    /// function. It represents the visual representation of the item.
+    /// \param[in] _data The node transformation data.
+    /// \return Updated node.
+    protected: QSGNode *updatePaintNode(QSGNode *_oldNode,
+        QQuickItem::UpdatePaintNodeData *_data) override;
+
+    /// \internal
+    /// \brief Pointer to private data.
+    private: std::unique_ptr<ImageItemPrivate> dataPtr;
+  };
 }
 }
 }
@@ -18,6 +18,7 @@ import QtQuick 2.9
 import QtQuick.Controls 2.2
 import QtQuick.Controls.Material 2.1
 import QtQuick.Layouts 1.3
+import ImageDisplay 1.0
 
 Rectangle {
   id: "imageDisplay"
@@ -31,27 +32,9 @@ Rectangle {
    */
   property bool showPicker: false
 
-  /**
-   * Unique name for this plugin instance
-   */
-  property string uniqueName: ""
-
   property int tooltipDelay: 500
   property int tooltipTimeout: 1000
 
-  onParentChanged: {
-    if (undefined === parent)
-      return;
-
-    uniqueName = parent.card().objectName + "imagedisplay";
-    image.reload();
-  }
-
-  Connections {
-    target: ImageDisplay
-    onNewImage: image.reload();
-  }
-
   ColumnLayout {
     id: imageDisplayColumn
     anchors.fill: parent
@@ -86,16 +69,11 @@ Rectangle {
         ToolTip.text: qsTr("Ignition transport topics publishing Image messages")
       }
     }
-    Image {
+    ImageItem {
       id: image
-      fillMode: Image.PreserveAspectFit
+      objectName: "imageItem"
       Layout.fillHeight: true
       Layout.fillWidth: true
-      verticalAlignment: Image.AlignTop
-      function reload() {
-        // Force image request to C++
-        source = "image://" + uniqueName + "/" + Math.random().toString(36).substr(2, 5);
-      }
     }
   }
 }
@@ -26,10 +26,17 @@ TransportPlotting::~TransportPlotting()
 }
 
 //////////////////////////////////////////
-void TransportPlotting::LoadConfig(const tinyxml2::XMLElement *)
+void TransportPlotting::LoadConfig(const tinyxml2::XMLElement *_pluginElem)
 {
   if (this->title.empty())
     this->title = "Transport plotting";
+
+  if (!_pluginElem)
+    return;
+
+  auto elem = _pluginElem->FirstChildElement("history_directory");
+  if (nullptr != elem && nullptr != elem->GetText())
+    this->dataPtr->SetHistoryDirectory(elem->GetText());
 }
 
 //////////////////////////////////////////
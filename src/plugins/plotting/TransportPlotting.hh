@@ -32,6 +32,12 @@ namespace plugins
 
 /// \brief Plots fields from Ignition Transport topics.
 /// Fields can be dragged from the Topic Viewer or the Component Inspector.
+///
+/// ## Configuration
+///
+/// * \<history_directory\> : Optional directory to log the plotted values
+///                           in. The logged values are loaded when a field is
+///                           plotted again, even after a restart.
 class TransportPlotting : public ignition::gui::Plugin
 {
   Q_OBJECT
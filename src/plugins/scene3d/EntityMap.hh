@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_GUI_PLUGINS_ENTITYMAP_HH_
+#define IGNITION_GUI_PLUGINS_ENTITYMAP_HH_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ignition
+{
+namespace gui
+{
+namespace plugins
+{
+  /// \brief Map of entity ids to values, with the values packed in a
+  /// contiguous array. Ids are looked up in an open-addressing index with
+  /// linear probing, so once the map has grown, inserting, finding and
+  /// erasing don't allocate, and iterating is a linear pass over the slots.
+  template<typename T>
+  class EntityMap
+  {
+    /// \brief Reserve space for a number of entities
+    /// \param[in] _count Number of entities
+    public: void Reserve(const std::size_t _count)
+    {
+      this->ids.reserve(_count);
+      this->values.reserve(_count);
+      if (_count * 2 > this->index.size())
+        this->Rehash(_count * 2);
+    }
+
+    /// \brief Number of entities in the map
+    /// \return Number of entities
+    public: std::size_t Size() const
+    {
+      return this->ids.size();
+    }
+
+    /// \brief Id of the entity in a slot
+    /// \param[in] _slot Slot, smaller than Size()
+    /// \return Entity id
+    public: unsigned int Id(const std::size_t _slot) const
+    {
+      return this->ids[_slot];
+    }
+
+    /// \brief Value of the entity in a slot
+    /// \param[in] _slot Slot, smaller than Size()
+    /// \return Entity value
+    public: T &Value(const std::size_t _slot)
+    {
+      return this->values[_slot];
+    }
+
+    /// \brief Find the value of an entity
+    /// \param[in] _id Entity id
+    /// \return Pointer to the value, null if the entity isn't in the map
+    public: T *Find(const unsigned int _id)
+    {
+      if (this->index.empty())
+        return nullptr;
+
+      auto entry = this->index[this->Probe(_id)];
+      return entry == 0 ? nullptr : &this->values[entry - 1];
+    }
+
+    /// \brief Get the value of an entity, inserting a default value if the
+    /// entity isn't in the map
+    /// \param[in] _id Entity id
+    /// \return Reference to the value
+    public: T &operator[](const unsigned int _id)
+    {
+      if ((this->ids.size() + 1) * 2 > this->index.size())
+        this->Rehash(std::max<std::size_t>(16, this->index.size() * 2));
+
+      auto pos = this->Probe(_id);
+      if (this->index[pos] == 0)
+      {
+        this->ids.push_back(_id);
+        this->values.emplace_back();
+        this->index[pos] = static_cast<uint32_t>(this->ids.size());
+      }
+      return this->values[this->index[pos] - 1];
+    }
+
+    /// \brief Remove an entity. The last slot is moved into the slot of
+    /// the removed entity.
+    /// \param[in] _id Entity id
+    /// \return True if the entity was in the map
+    public: bool Erase(const unsigned int _id)
+    {
+      if (this->index.empty())
+        return false;
+
+      auto pos = this->Probe(_id);
+      if (this->index[pos] == 0)
+        return false;
+
+      auto slot = this->index[pos] - 1;
+
+      // Backward shift deletion, so no tombstones are needed
+      auto mask = this->index.size() - 1;
+      auto next = pos;
+      this->index[pos] = 0;
+      while (true)
+      {
+        next = (next + 1) & mask;
+        if (this->index[next] == 0)
+          break;
+
+        auto home = this->Home(this->ids[this->index[next] - 1]);
+        bool stay = pos <= next ? (pos < home && home <= next) :
+                                  (pos < home || home <= next);
+        if (stay)
+          continue;
+
+        this->index[pos] = this->index[next];
+        this->index[next] = 0;
+        pos = next;
+      }
+
+      // Keep the slots packed
+      auto last = this->ids.size() - 1;
+      if (slot != last)
+      {
+        this->index[this->Probe(this->ids[last])] = slot + 1;
+        this->ids[slot] = this->ids[last];
+        this->values[slot] = std::move(this->values[last]);
+      }
+      this->ids.pop_back();
+      this->values.pop_back();
+      return true;
+    }
+
+    /// \brief Remove all entities, keeping the allocated memory
+    public: void Clear()
+    {
+      if (this->ids.empty())
+        return;
+
+      this->ids.clear();
+      this->values.clear();
+      std::fill(this->index.begin(), this->index.end(), 0u);
+    }
+
+    /// \brief Position of an entity id in the index when there are no
+    /// collisions
+    /// \param[in] _id Entity id
+    /// \return Position in the index
+    private: std::size_t Home(unsigned int _id) const
+    {
+      _id ^= _id >> 16;
+      _id *= 0x45d9f3bu;
+      _id ^= _id >> 16;
+      return _id & (this->index.size() - 1);
+    }
+
+    /// \brief Position of an entity id in the index, or of the empty entry
+    /// where it would be inserted. The index must not be empty.
+    /// \param[in] _id Entity id
+    /// \return Position in the index
+    private: std::size_t Probe(const unsigned int _id) const
+    {
+      auto mask = this->index.size() - 1;
+      auto pos = this->Home(_id);
+      while (this->index[pos] != 0 && this->ids[this->index[pos] - 1] != _id)
+        pos = (pos + 1) & mask;
+      return pos;
+    }
+
+    /// \brief Grow the index and insert the entities again
+    /// \param[in] _size Minimum size of the index
+    private: void Rehash(const std::size_t _size)
+    {
+      std::size_t size = 16;
+      while (size < _size)
+        size *= 2;
+
+      this->index.assign(size, 0u);
+      for (std::size_t slot = 0; slot < this->ids.size(); ++slot)
+        this->index[this->Probe(this->ids[slot])] =
+            static_cast<uint32_t>(slot + 1);
+    }
+
+    /// \brief Entity id of each slot
+    private: std::vector<unsigned int> ids;
+
+    /// \brief Value of each slot
+    private: std::vector<T> values;
+
+    /// \brief Open-addressing index of slot + 1 per entity id, 0 when
+    /// the entry is empty. The size is a power of 2.
+    private: std::vector<uint32_t> index;
+  };
+}
+}
+}
+
+#endif
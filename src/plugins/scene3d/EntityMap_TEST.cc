@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "EntityMap.hh"
+
+using namespace ignition;
+using namespace gui;
+using namespace plugins;
+
+/////////////////////////////////////////////////
+/// \brief Position of an id in an index of 16 entries without collisions,
+/// same mix as EntityMap
+std::size_t Home(unsigned int _id)
+{
+  _id ^= _id >> 16;
+  _id *= 0x45d9f3bu;
+  _id ^= _id >> 16;
+  return _id & 15u;
+}
+
+/////////////////////////////////////////////////
+/// \brief Find ids with the same home in an index of 16 entries
+std::vector<unsigned int> Colliding(std::size_t _home, std::size_t _count)
+{
+  std::vector<unsigned int> ids;
+  for (unsigned int id = 1; ids.size() < _count; ++id)
+  {
+    if (Home(id) == _home)
+      ids.push_back(id);
+  }
+  return ids;
+}
+
+/////////////////////////////////////////////////
+/// \brief Check that the slots hold exactly the expected entities
+void ExpectEntities(EntityMap<int> &_map,
+    const std::map<unsigned int, int> &_expected)
+{
+  ASSERT_EQ(_expected.size(), _map.Size());
+
+  std::map<unsigned int, int> slots;
+  for (std::size_t slot = 0; slot < _map.Size(); ++slot)
+    slots[_map.Id(slot)] = _map.Value(slot);
+  EXPECT_EQ(_expected, slots);
+
+  for (const auto &entity : _expected)
+  {
+    auto value = _map.Find(entity.first);
+    ASSERT_NE(nullptr, value) << entity.first;
+    EXPECT_EQ(entity.second, *value);
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(EntityMapTest, Empty)
+{
+  EntityMap<int> map;
+  EXPECT_EQ(0u, map.Size());
+  EXPECT_EQ(nullptr, map.Find(1));
+  EXPECT_FALSE(map.Erase(1));
+  map.Clear();
+  EXPECT_EQ(0u, map.Size());
+}
+
+/////////////////////////////////////////////////
+TEST(EntityMapTest, InsertFindErase)
+{
+  EntityMap<int> map;
+  map[10] = 100;
+  map[20] = 200;
+  map[30] = 300;
+  ExpectEntities(map, {{10, 100}, {20, 200}, {30, 300}});
+
+  // existing entity
+  map[20] += 2;
+  EXPECT_EQ(202, *map.Find(20));
+  EXPECT_EQ(3u, map.Size());
+
+  // default value
+  EXPECT_EQ(0, map[40]);
+  EXPECT_EQ(nullptr, map.Find(50));
+
+  EXPECT_TRUE(map.Erase(20));
+  EXPECT_FALSE(map.Erase(20));
+  EXPECT_EQ(nullptr, map.Find(20));
+  ExpectEntities(map, {{10, 100}, {30, 300}, {40, 0}});
+
+  map.Clear();
+  ExpectEntities(map, {});
+  map[20] = 2;
+  ExpectEntities(map, {{20, 2}});
+}
+
+/////////////////////////////////////////////////
+TEST(EntityMapTest, Collisions)
+{
+  // four ids from entry 3 to 6, and one at its home right after them
+  auto ids = Colliding(3, 4);
+  auto next = Colliding(7, 1)[0];
+
+  EntityMap<int> map;
+  for (auto id : ids)
+    map[id] = static_cast<int>(id);
+  map[next] = 7;
+  ExpectEntities(map, {{ids[0], ids[0]}, {ids[1], ids[1]}, {ids[2], ids[2]},
+      {ids[3], ids[3]}, {next, 7}});
+
+  // the entries after the erased one are shifted back, but not the one at
+  // its home
+  EXPECT_TRUE(map.Erase(ids[1]));
+  EXPECT_EQ(nullptr, map.Find(ids[1]));
+  ExpectEntities(map, {{ids[0], ids[0]}, {ids[2], ids[2]}, {ids[3], ids[3]},
+      {next, 7}});
+
+  EXPECT_TRUE(map.Erase(ids[0]));
+  ExpectEntities(map, {{ids[2], ids[2]}, {ids[3], ids[3]}, {next, 7}});
+
+  map[ids[1]] = 1;
+  ExpectEntities(map, {{ids[1], 1}, {ids[2], ids[2]}, {ids[3], ids[3]},
+      {next, 7}});
+}
+
+/////////////////////////////////////////////////
+TEST(EntityMapTest, WrapAround)
+{
+  // the probes of these ids wrap around to the start of the index
+  auto last = Colliding(15, 3);
+  auto first = Colliding(0, 1);
+  auto home = Colliding(3, 1)[0];
+
+  EntityMap<int> map;
+  map[last[0]] = 1;
+  map[last[1]] = 2;
+  map[last[2]] = 3;
+  map[first[0]] = 4;
+  map[home] = 5;
+  ExpectEntities(map, {{last[0], 1}, {last[1], 2}, {last[2], 3},
+      {first[0], 4}, {home, 5}});
+
+  // shifting back across the end of the index, up to the entry at its home
+  EXPECT_TRUE(map.Erase(last[0]));
+  ExpectEntities(map, {{last[1], 2}, {last[2], 3}, {first[0], 4},
+      {home, 5}});
+
+  // erasing in the middle of the wrapped run
+  EXPECT_TRUE(map.Erase(last[2]));
+  ExpectEntities(map, {{last[1], 2}, {first[0], 4}, {home, 5}});
+
+  EXPECT_TRUE(map.Erase(last[1]));
+  ExpectEntities(map, {{first[0], 4}, {home, 5}});
+
+  // the entry after the end of the index is at its home, so it stays. The
+  // erased entity is in the last slot, so no slot is moved.
+  map.Clear();
+  map[first[0]] = 4;
+  map[last[0]] = 1;
+  EXPECT_TRUE(map.Erase(last[0]));
+  ExpectEntities(map, {{first[0], 4}});
+}
+
+/////////////////////////////////////////////////
+TEST(EntityMapTest, Compaction)
+{
+  EntityMap<int> map;
+  for (unsigned int id = 1; id <= 5; ++id)
+    map[id] = static_cast<int>(id * 10);
+
+  // the last slot is moved into the erased one
+  EXPECT_TRUE(map.Erase(2));
+  ASSERT_EQ(4u, map.Size());
+  EXPECT_EQ(1u, map.Id(0));
+  EXPECT_EQ(5u, map.Id(1));
+  EXPECT_EQ(50, map.Value(1));
+  EXPECT_EQ(3u, map.Id(2));
+  EXPECT_EQ(4u, map.Id(3));
+  ExpectEntities(map, {{1, 10}, {3, 30}, {4, 40}, {5, 50}});
+
+  // erasing the last slot doesn't move anything
+  EXPECT_TRUE(map.Erase(4));
+  ASSERT_EQ(3u, map.Size());
+  EXPECT_EQ(1u, map.Id(0));
+  EXPECT_EQ(5u, map.Id(1));
+  EXPECT_EQ(3u, map.Id(2));
+
+  // the moved entity is still found and updated in its new slot
+  map[5] = 55;
+  EXPECT_EQ(55, map.Value(1));
+  ExpectEntities(map, {{1, 10}, {3, 30}, {5, 55}});
+}
+
+/////////////////////////////////////////////////
+TEST(EntityMapTest, Rehash)
+{
+  EntityMap<int> map;
+  std::map<unsigned int, int> expected;
+
+  // grow the index several times
+  for (unsigned int id = 0; id < 1000; ++id)
+  {
+    map[id * 7919u] = static_cast<int>(id);
+    expected[id * 7919u] = static_cast<int>(id);
+  }
+  ExpectEntities(map, expected);
+
+  // reserving more keeps the entities
+  map.Reserve(5000);
+  ExpectEntities(map, expected);
+
+  // reserving less doesn't shrink the index
+  map.Reserve(10);
+  ExpectEntities(map, expected);
+
+  for (unsigned int id = 0; id < 1000; id += 2)
+  {
+    EXPECT_TRUE(map.Erase(id * 7919u));
+    expected.erase(id * 7919u);
+  }
+  ExpectEntities(map, expected);
+}
+
+/////////////////////////////////////////////////
+TEST(EntityMapTest, Random)
+{
+  // few ids in a small index, for many collisions and wrap-arounds
+  std::mt19937 random(42);
+  std::uniform_int_distribution<unsigned int> idDist(0, 40);
+  std::uniform_int_distribution<int> opDist(0, 2);
+
+  EntityMap<int> map;
+  std::map<unsigned int, int> expected;
+  for (int i = 0; i < 20000; ++i)
+  {
+    auto id = idDist(random);
+    if (opDist(random) == 0)
+    {
+      EXPECT_EQ(expected.erase(id) > 0, map.Erase(id));
+    }
+    else
+    {
+      map[id] = i;
+      expected[id] = i;
+    }
+
+    if (i % 100 == 0)
+      ExpectEntities(map, expected);
+  }
+  ExpectEntities(map, expected);
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_GUI_PLUGINS_PENDINGPOSES_HH_
+#define IGNITION_GUI_PLUGINS_PENDINGPOSES_HH_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <ignition/math/Pose3.hh>
+
+#include "EntityMap.hh"
+
+namespace ignition
+{
+namespace gui
+{
+namespace plugins
+{
+  /// \brief Latest poses of entities which aren't created yet, kept until
+  /// they are. The number of poses is capped and the poses expire, so poses
+  /// of entities which are never created don't accumulate.
+  class PendingPoses
+  {
+    /// \brief Constructor
+    /// \param[in] _limit Maximum number of pending poses
+    /// \param[in] _maxAge Time after which pending poses are dropped
+    public: PendingPoses(const std::size_t _limit,
+                         const std::chrono::steady_clock::duration _maxAge)
+      : limit(_limit), maxAge(_maxAge)
+    {
+    }
+
+    /// \brief Keep the pose of an entity which isn't created yet. A newer
+    /// pose of the entity replaces the previous one.
+    /// \param[in] _id Entity id
+    /// \param[in] _pose Pose of the entity
+    /// \param[in] _now Frame time
+    public: void Keep(const unsigned int _id, const math::Pose3d &_pose,
+        const std::chrono::steady_clock::time_point &_now)
+    {
+      auto pending = this->poses.Find(_id);
+      if (!pending)
+      {
+        // drop poses of unknown entities rather than growing without bound
+        if (this->poses.Size() >= this->limit)
+        {
+          this->dropped++;
+          return;
+        }
+        pending = &this->poses[_id];
+      }
+      pending->pose = _pose;
+      pending->time = _now;
+    }
+
+    /// \brief Remove the pending poses older than the age limit
+    /// \param[in] _now Frame time
+    public: void Expire(const std::chrono::steady_clock::time_point &_now)
+    {
+      // erasing moves the last slot into the erased one, so it's checked
+      // again
+      for (std::size_t slot = 0; slot < this->poses.Size();)
+      {
+        if (_now - this->poses.Value(slot).time > this->maxAge)
+        {
+          this->poses.Erase(this->poses.Id(slot));
+          this->dropped++;
+        }
+        else
+        {
+          ++slot;
+        }
+      }
+    }
+
+    /// \brief Take the pose received for an entity before it was created
+    /// \param[in] _id Entity id
+    /// \param[out] _pose Pose of the entity
+    /// \return True if there was a pose for the entity
+    public: bool Take(const unsigned int _id, math::Pose3d &_pose)
+    {
+      auto pending = this->poses.Find(_id);
+      if (!pending)
+        return false;
+
+      _pose = pending->pose;
+      this->poses.Erase(_id);
+      return true;
+    }
+
+    /// \brief Remove the pose of an entity, e.g. when it's deleted
+    /// \param[in] _id Entity id
+    public: void Erase(const unsigned int _id)
+    {
+      this->poses.Erase(_id);
+    }
+
+    /// \brief Number of pending poses
+    /// \return Number of poses
+    public: std::size_t Size() const
+    {
+      return this->poses.Size();
+    }
+
+    /// \brief Number of poses dropped because of the cap or the age limit
+    /// \return Number of dropped poses
+    public: uint64_t Dropped() const
+    {
+      return this->dropped;
+    }
+
+    /// \brief Pose received for an entity which wasn't created yet
+    private: struct PendingPose
+    {
+      /// \brief Latest pose of the entity
+      math::Pose3d pose;
+
+      /// \brief Frame time when the pose was received
+      std::chrono::steady_clock::time_point time;
+    };
+
+    /// \brief Pending pose of each entity
+    private: EntityMap<PendingPose> poses;
+
+    /// \brief Maximum number of pending poses
+    private: std::size_t limit;
+
+    /// \brief Time after which pending poses are dropped
+    private: std::chrono::steady_clock::duration maxAge;
+
+    /// \brief Number of poses dropped
+    private: uint64_t dropped = 0u;
+  };
+}
+}
+}
+
+#endif
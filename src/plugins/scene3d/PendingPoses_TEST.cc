@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "PendingPoses.hh"
+
+using namespace ignition;
+using namespace gui;
+using namespace plugins;
+
+/////////////////////////////////////////////////
+TEST(PendingPosesTest, Take)
+{
+  PendingPoses poses(10u, std::chrono::seconds(5));
+  auto now = std::chrono::steady_clock::now();
+
+  math::Pose3d pose;
+  EXPECT_FALSE(poses.Take(1, pose));
+
+  // the pose received before the entity was created is applied when it is,
+  // and only the latest one is kept
+  poses.Keep(1, math::Pose3d(1, 0, 0, 0, 0, 0), now);
+  poses.Keep(2, math::Pose3d(2, 0, 0, 0, 0, 0), now);
+  poses.Keep(1, math::Pose3d(3, 0, 0, 0, 0, 0), now);
+  EXPECT_EQ(2u, poses.Size());
+
+  EXPECT_TRUE(poses.Take(1, pose));
+  EXPECT_EQ(math::Pose3d(3, 0, 0, 0, 0, 0), pose);
+  EXPECT_EQ(1u, poses.Size());
+
+  // taken only once
+  EXPECT_FALSE(poses.Take(1, pose));
+
+  // deleted entities lose their pose
+  poses.Erase(2);
+  EXPECT_FALSE(poses.Take(2, pose));
+  EXPECT_EQ(0u, poses.Size());
+  EXPECT_EQ(0u, poses.Dropped());
+}
+
+/////////////////////////////////////////////////
+TEST(PendingPosesTest, Limit)
+{
+  PendingPoses poses(3u, std::chrono::seconds(5));
+  auto now = std::chrono::steady_clock::now();
+
+  for (unsigned int id = 1; id <= 3; ++id)
+    poses.Keep(id, math::Pose3d(id, 0, 0, 0, 0, 0), now);
+  EXPECT_EQ(3u, poses.Size());
+  EXPECT_EQ(0u, poses.Dropped());
+
+  // new entities are dropped once the cap is reached
+  poses.Keep(4, math::Pose3d(4, 0, 0, 0, 0, 0), now);
+  EXPECT_EQ(3u, poses.Size());
+  EXPECT_EQ(1u, poses.Dropped());
+
+  math::Pose3d pose;
+  EXPECT_FALSE(poses.Take(4, pose));
+
+  // the entities already kept are still updated
+  poses.Keep(2, math::Pose3d(5, 0, 0, 0, 0, 0), now);
+  EXPECT_EQ(1u, poses.Dropped());
+  EXPECT_TRUE(poses.Take(2, pose));
+  EXPECT_EQ(math::Pose3d(5, 0, 0, 0, 0, 0), pose);
+
+  // there's room again
+  poses.Keep(4, math::Pose3d(4, 0, 0, 0, 0, 0), now);
+  EXPECT_EQ(3u, poses.Size());
+  EXPECT_EQ(1u, poses.Dropped());
+  EXPECT_TRUE(poses.Take(4, pose));
+}
+
+/////////////////////////////////////////////////
+TEST(PendingPosesTest, Expire)
+{
+  PendingPoses poses(10u, std::chrono::seconds(5));
+  auto start = std::chrono::steady_clock::now();
+
+  for (unsigned int id = 1; id <= 4; ++id)
+    poses.Keep(id, math::Pose3d(id, 0, 0, 0, 0, 0), start);
+  poses.Keep(5, math::Pose3d(5, 0, 0, 0, 0, 0),
+      start + std::chrono::seconds(3));
+
+  // up to the age limit
+  poses.Expire(start + std::chrono::seconds(5));
+  EXPECT_EQ(5u, poses.Size());
+  EXPECT_EQ(0u, poses.Dropped());
+
+  // a newer pose restarts the age of its entity
+  poses.Keep(2, math::Pose3d(6, 0, 0, 0, 0, 0),
+      start + std::chrono::seconds(4));
+
+  // all the expired poses are dropped, including the ones moved into the
+  // slots of the erased ones
+  poses.Expire(start + std::chrono::seconds(6));
+  EXPECT_EQ(2u, poses.Size());
+  EXPECT_EQ(3u, poses.Dropped());
+
+  math::Pose3d pose;
+  EXPECT_FALSE(poses.Take(1, pose));
+  EXPECT_FALSE(poses.Take(3, pose));
+  EXPECT_FALSE(poses.Take(4, pose));
+  EXPECT_TRUE(poses.Take(2, pose));
+  EXPECT_EQ(math::Pose3d(6, 0, 0, 0, 0, 0), pose);
+  EXPECT_TRUE(poses.Take(5, pose));
+
+  poses.Expire(start + std::chrono::seconds(60));
+  EXPECT_EQ(0u, poses.Size());
+  EXPECT_EQ(3u, poses.Dropped());
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_GUI_PLUGINS_POSEBUFFER_HH_
+#define IGNITION_GUI_PLUGINS_POSEBUFFER_HH_
+
+#include <atomic>
+#include <cstdint>
+
+#include "EntityMap.hh"
+
+namespace ignition
+{
+namespace gui
+{
+namespace plugins
+{
+  /// \brief Position and orientation fields of a pose message, copied as
+  /// they are. They're only converted to a pose on the render thread, once
+  /// per frame, so poses overwritten by newer messages cost nothing.
+  struct RawPose
+  {
+    /// \brief Position x, y and z
+    double position[3];
+
+    /// \brief Orientation w, x, y and z
+    double orientation[4];
+  };
+
+  /// \brief Latest-wins handoff of pose snapshots from the transport
+  /// threads to the render thread, using three buffers. The writer fills
+  /// the back buffer and publishes it by swapping it with the middle one,
+  /// the reader takes the middle buffer by swapping it with the front one.
+  /// Neither side ever waits for the other. A snapshot which hasn't been
+  /// read yet is taken back by the writer and updated with the new poses,
+  /// so entities which aren't in every message don't lose their updates.
+  class PoseBuffer
+  {
+    /// \brief Get the back buffer, to be filled and published by the writer
+    /// \return Poses which haven't been read yet
+    public: EntityMap<RawPose> &BeginWrite()
+    {
+      // Take back the published snapshot if the reader hasn't taken it, and
+      // leave the empty back buffer in its place
+      auto middle = this->middle.load(std::memory_order_acquire);
+      if ((middle & kDirty) &&
+          this->middle.compare_exchange_strong(middle, this->back,
+              std::memory_order_acq_rel))
+      {
+        this->back = middle & kIndex;
+        this->coalesced.fetch_add(1, std::memory_order_relaxed);
+      }
+      return this->buffers[this->back];
+    }
+
+    /// \brief Publish the back buffer filled since BeginWrite()
+    public: void EndWrite()
+    {
+      // The buffer which comes back has been cleared by the reader, or is
+      // the empty buffer left by BeginWrite()
+      this->back = this->middle.exchange(this->back | kDirty,
+          std::memory_order_acq_rel) & kIndex;
+    }
+
+    /// \brief Take the latest published snapshot. The previous snapshot
+    /// returned is cleared.
+    /// \return Poses published since the last call, null if there are none
+    public: EntityMap<RawPose> *Read()
+    {
+      if (!(this->middle.load(std::memory_order_acquire) & kDirty))
+        return nullptr;
+
+      this->buffers[this->front].Clear();
+      this->front = this->middle.exchange(this->front,
+          std::memory_order_acq_rel) & kIndex;
+      return &this->buffers[this->front];
+    }
+
+    /// \brief Number of snapshots taken back by the writer before they were
+    /// read, i.e. pose msgs merged with the next one
+    /// \return Number of coalesced snapshots
+    public: uint64_t Coalesced() const
+    {
+      return this->coalesced.load(std::memory_order_relaxed);
+    }
+
+    /// \brief Flag set on the middle index when it holds a snapshot which
+    /// hasn't been read
+    private: static constexpr unsigned int kDirty = 4u;
+
+    /// \brief Mask of the buffer index in the middle index
+    private: static constexpr unsigned int kIndex = 3u;
+
+    /// \brief The three buffers
+    private: EntityMap<RawPose> buffers[3];
+
+    /// \brief Index of the buffer owned by the writer
+    private: unsigned int back = 0u;
+
+    /// \brief Index of the published buffer, with the kDirty flag
+    private: std::atomic<unsigned int> middle{1u};
+
+    /// \brief Index of the buffer owned by the reader
+    private: unsigned int front = 2u;
+
+    /// \brief Number of coalesced snapshots
+    private: std::atomic<uint64_t> coalesced{0u};
+  };
+}
+}
+}
+
+#endif
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <map>
+#include <thread>
+
+#include "PoseBuffer.hh"
+
+using namespace ignition;
+using namespace gui;
+using namespace plugins;
+
+/////////////////////////////////////////////////
+/// \brief Publish a pose msg with the same x for all its entities
+void Write(PoseBuffer &_buffer, std::initializer_list<unsigned int> _ids,
+    double _x)
+{
+  auto &poses = _buffer.BeginWrite();
+  for (auto id : _ids)
+    poses[id] = RawPose{{_x, 0, 0}, {1, 0, 0, 0}};
+  _buffer.EndWrite();
+}
+
+/////////////////////////////////////////////////
+/// \brief Take the latest snapshot as a map of entity id to x
+std::map<unsigned int, double> Read(PoseBuffer &_buffer)
+{
+  std::map<unsigned int, double> result;
+  auto poses = _buffer.Read();
+  if (!poses)
+    return result;
+
+  for (std::size_t slot = 0; slot < poses->Size(); ++slot)
+    result[poses->Id(slot)] = poses->Value(slot).position[0];
+  return result;
+}
+
+/////////////////////////////////////////////////
+TEST(PoseBufferTest, Empty)
+{
+  PoseBuffer buffer;
+  EXPECT_EQ(nullptr, buffer.Read());
+  EXPECT_EQ(0u, buffer.Coalesced());
+}
+
+/////////////////////////////////////////////////
+TEST(PoseBufferTest, WriteRead)
+{
+  PoseBuffer buffer;
+  Write(buffer, {1, 2}, 1.0);
+
+  auto expected = std::map<unsigned int, double>{{1, 1.0}, {2, 1.0}};
+  EXPECT_EQ(expected, Read(buffer));
+
+  // nothing new
+  EXPECT_EQ(nullptr, buffer.Read());
+
+  // the previous snapshot is cleared before it's reused
+  Write(buffer, {3}, 2.0);
+  expected = {{3, 2.0}};
+  EXPECT_EQ(expected, Read(buffer));
+  Write(buffer, {4}, 3.0);
+  expected = {{4, 3.0}};
+  EXPECT_EQ(expected, Read(buffer));
+  EXPECT_EQ(0u, buffer.Coalesced());
+}
+
+/////////////////////////////////////////////////
+TEST(PoseBufferTest, TakeBack)
+{
+  PoseBuffer buffer;
+  Write(buffer, {1, 2}, 1.0);
+
+  // the writer takes back the snapshot which wasn't read and updates it
+  Write(buffer, {2, 3}, 2.0);
+  EXPECT_EQ(1u, buffer.Coalesced());
+
+  auto expected =
+      std::map<unsigned int, double>{{1, 1.0}, {2, 2.0}, {3, 2.0}};
+  EXPECT_EQ(expected, Read(buffer));
+  EXPECT_EQ(nullptr, buffer.Read());
+
+  // after a read, the next snapshot starts empty
+  Write(buffer, {3}, 3.0);
+  expected = {{3, 3.0}};
+  EXPECT_EQ(expected, Read(buffer));
+  EXPECT_EQ(1u, buffer.Coalesced());
+}
+
+/////////////////////////////////////////////////
+TEST(PoseBufferTest, NoReader)
+{
+  // a reader which doesn't read for a while loses no poses, and only gets
+  // the latest one of each entity
+  PoseBuffer buffer;
+  std::map<unsigned int, double> expected;
+  for (unsigned int i = 0; i < 100; ++i)
+  {
+    Write(buffer, {i % 10, 100 + i}, i);
+    expected[i % 10] = i;
+    expected[100 + i] = i;
+  }
+  EXPECT_EQ(99u, buffer.Coalesced());
+  EXPECT_EQ(expected, Read(buffer));
+  EXPECT_EQ(nullptr, buffer.Read());
+}
+
+/////////////////////////////////////////////////
+TEST(PoseBufferTest, Threads)
+{
+  PoseBuffer buffer;
+  std::atomic<bool> done{false};
+  const unsigned int kMsgs = 100000;
+
+  // each msg has the poses of a few entities
+  std::thread writer([&]
+  {
+    for (unsigned int i = 1; i <= kMsgs; ++i)
+      Write(buffer, {0, i % 7 + 1, i % 13 + 10}, i);
+    done = true;
+  });
+
+  std::map<unsigned int, double> latest;
+  unsigned int reads = 0;
+  bool ordered = true;
+  while (true)
+  {
+    bool finished = done;
+    for (const auto &pose : Read(buffer))
+    {
+      // never an older pose than one already read
+      if (pose.second <= latest[pose.first])
+        ordered = false;
+      latest[pose.first] = pose.second;
+      ++reads;
+    }
+    if (finished)
+      break;
+  }
+  writer.join();
+  EXPECT_TRUE(ordered);
+  EXPECT_GT(reads, 0u);
+
+  // the last pose of every entity arrived
+  std::map<unsigned int, double> expected;
+  for (unsigned int i = kMsgs - 13; i <= kMsgs; ++i)
+  {
+    expected[0] = i;
+    expected[i % 7 + 1] = i;
+    expected[i % 13 + 10] = i;
+  }
+  EXPECT_EQ(expected, latest);
+}
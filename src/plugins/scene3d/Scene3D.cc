@@ -15,12 +15,27 @@
  *
 */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iomanip>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include <QOpenGLTimerQuery>
+
 #include <ignition/common/Console.hh>
 #include <ignition/common/MouseEvent.hh>
 #include <ignition/plugin/Register.hh>
@@ -54,6 +69,10 @@
 #include "ignition/gui/GuiEvents.hh"
 #include "ignition/gui/MainWindow.hh"
 
+#include "EntityMap.hh"
+#include "PendingPoses.hh"
+#include "PoseBuffer.hh"
+#include "SceneContents.hh"
 #include "Scene3D.hh"
 
 namespace ignition
@@ -62,6 +81,103 @@ namespace gui
 {
 namespace plugins
 {
+  /// \brief Material shared by the visuals with identical materials
+  struct SharedMaterial
+  {
+    /// \brief Material set on the geometries, which don't own it
+    rendering::MaterialPtr material;
+
+    /// \brief Number of geometries using the material
+    unsigned int users = 0u;
+  };
+
+  /// \brief Counters of the scene manager
+  struct SceneStats
+  {
+    /// \brief Number of visuals
+    std::size_t visuals = 0u;
+
+    /// \brief Number of lights
+    std::size_t lights = 0u;
+
+    /// \brief Number of poses waiting for their entity to be created
+    std::size_t pendingPoses = 0u;
+
+    /// \brief Number of models waiting to be created
+    std::size_t pendingModels = 0u;
+
+    /// \brief Total number of pose msgs received
+    uint64_t poseMsgs = 0u;
+
+    /// \brief Total number of pose msgs merged with the next one before
+    /// the render thread took them
+    uint64_t coalescedPoseMsgs = 0u;
+
+    /// \brief Total number of poses of unknown entities dropped
+    uint64_t droppedPoses = 0u;
+  };
+
+  /// \brief Rolling window of the durations of a rendering stage
+  class StageTimer
+  {
+    /// \brief Add a duration
+    /// \param[in] _ms Duration in milliseconds
+    public: void Add(double _ms)
+    {
+      if (this->samples.size() < kWindow)
+        this->samples.push_back(_ms);
+      else
+        this->samples[this->next] = _ms;
+      this->next = (this->next + 1) % kWindow;
+    }
+
+    /// \brief Percentile of the durations in the window
+    /// \param[in] _percent Percentile, between 0 and 100
+    /// \return Duration in milliseconds, 0 if there are none
+    public: double Percentile(double _percent) const
+    {
+      if (this->samples.empty())
+        return 0.0;
+
+      std::vector<double> sorted(this->samples);
+      auto rank = static_cast<std::size_t>(std::lround(
+          _percent / 100.0 * (sorted.size() - 1)));
+      std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+      return sorted[rank];
+    }
+
+    /// \brief Number of durations kept
+    private: static constexpr std::size_t kWindow = 240u;
+
+    /// \brief Durations in milliseconds
+    private: std::vector<double> samples;
+
+    /// \brief Index of the next duration to replace
+    private: std::size_t next = 0u;
+  };
+
+  /// \brief Scene or deletion message on its way through the scene loading
+  /// pipeline. Both go through the same queue, so deletions are applied in
+  /// the order they were received with respect to scenes.
+  struct SceneUpdate
+  {
+    /// \brief Scene to load, empty for deletion messages
+    public: msgs::Scene scene;
+
+    /// \brief Entities to delete once the scene is loaded
+    public: std::vector<unsigned int> deletions;
+
+    /// \brief Content hash of each model of the scene
+    public: std::vector<std::size_t> modelHashes;
+
+    /// \brief Content hash of each light of the scene
+    public: std::vector<std::size_t> lightHashes;
+
+    /// \brief Mesh of each mesh file of the scene, loaded by the loading
+    /// thread, null if it couldn't be loaded
+    public: std::unordered_map<std::string, const common::Mesh *> meshes;
+  };
+
   /// \brief Scene manager class for loading and managing objects in the scene
   class SceneManager
   {
@@ -80,6 +196,9 @@ namespace plugins
                          const std::string &_sceneTopic,
                          rendering::ScenePtr _scene);
 
+    /// \brief Destructor
+    public: ~SceneManager();
+
     /// \brief Load the scene manager
     /// \param[in] _service Ign transport service name
     /// \param[in] _poseTopic Ign transport pose topic name
@@ -96,15 +215,52 @@ namespace plugins
     public: void Request();
 
     /// \brief Update the scene based on pose msgs received
-    public: void Update();
+    /// \return True if the scene changed
+    public: bool Update();
+
+    /// \brief Get the counters of the scene manager. Called by the render
+    /// thread.
+    /// \return Scene counters
+    public: SceneStats Stats() const;
+
+    /// \brief Set the function called when poses are received or scene msgs
+    /// are ready to be applied. Must be set before Load().
+    /// \param[in] _wake Function to call
+    public: void SetWakeCallback(const std::function<void()> &_wake);
 
     /// \brief Callback function for the pose topic
     /// \param[in] _msg Pose vector msg
     private: void OnPoseVMsg(const msgs::Pose_V &_msg);
 
-    /// \brief Load the scene from a scene msg
-    /// \param[in] _msg Scene msg
-    private: void LoadScene(const msgs::Scene &_msg);
+    /// \brief Apply a scene msg as a diff against the loaded entities.
+    /// Unknown lights are loaded and unknown models are queued to be loaded
+    /// by LoadPendingModels(). Entities whose content changed are replaced,
+    /// and identical entities are skipped.
+    /// \param[in] _update Scene update, with the hashes of its entities
+    private: void LoadScene(const SceneUpdate &_update);
+
+    /// \brief Remove a model from the queue of models to be loaded
+    /// \param[in] _id Model id
+    private: void RemovePendingModel(const unsigned int _id);
+
+    /// \brief Load queued models until the time budget of the frame is
+    /// spent. At least one model is loaded per call.
+    private: void LoadPendingModels();
+
+    /// \brief Queue a scene or deletion msg for the loading thread
+    /// \param[in] _update Scene update
+    private: void QueueUpdate(SceneUpdate &&_update);
+
+    /// \brief Loading thread, which parses the meshes of the queued scene
+    /// msgs before handing them to the render thread
+    private: void RunLoadThread();
+
+    /// \brief Load the meshes of a model, and of its nested models, in the
+    /// mesh manager
+    /// \param[in] _msg Model msg
+    /// \param[in, out] _meshes Loaded mesh of each mesh file
+    private: static void PreloadMeshes(const msgs::Model &_msg,
+        std::unordered_map<std::string, const common::Mesh *> &_meshes);
 
     /// \brief Callback function for the request topic
     /// \param[in] _msg Deletion message
@@ -147,6 +303,32 @@ namespace plugins
     /// \return Material object created from the msg
     private: rendering::MaterialPtr LoadMaterial(const msgs::Material &_msg);
 
+    /// \brief Get the material of a visual msg, shared with the other
+    /// visuals which have the same material and transparency. Each call
+    /// counts a user of the material, see ReleaseMaterial.
+    /// \param[in] _msg Visual msg
+    /// \return Material of the visual
+    private: rendering::MaterialPtr CachedMaterial(const msgs::Visual &_msg);
+
+    /// \brief Remove a user of a shared material, destroying the material
+    /// once it has no users left
+    /// \param[in] _material Material, ignored if it isn't shared
+    private: void ReleaseMaterial(const rendering::MaterialPtr &_material);
+
+    /// \brief Get the material of a geometry to change it for that geometry
+    /// only. A shared material is cloned for the geometry first, so the
+    /// change doesn't leak into the other visuals sharing it.
+    /// \param[in] _geom Geometry
+    /// \return Material owned by the geometry
+    private: rendering::MaterialPtr UniqueMaterial(
+        const rendering::GeometryPtr &_geom);
+
+    /// \brief Get the shared materials used by a visual and its descendants
+    /// \param[in] _visual Visual
+    /// \param[out] _materials Shared materials, one per geometry using them
+    private: void SharedMaterials(const rendering::VisualPtr &_visual,
+        std::vector<rendering::MaterialPtr> &_materials) const;
+
     /// \brief Load a light from a light msg
     /// \param[in] _msg Light msg
     /// \return Light object created from the msg
@@ -171,29 +353,82 @@ namespace plugins
     //// \brief Pointer to the rendering scene
     private: rendering::ScenePtr scene;
 
-    //// \brief Mutex to protect the pose msgs
+    //// \brief Mutex to protect the loading queues
     private: std::mutex mutex;
 
-    /// \brief Map of entity id to pose
-    private: std::map<unsigned int, math::Pose3d> poses;
+    //// \brief Mutex to serialize the pose msgs of different transport
+    /// threads. It's never locked by the render thread.
+    private: std::mutex poseMutex;
+
+    /// \brief Latest poses received, per entity id
+    private: PoseBuffer poses;
 
     /// \brief Map of entity id to initial local poses
     /// This is currently used to handle the normal vector in plane visuals. In
     /// general, this can be used to store any local transforms between the
     /// parent Visual and geometry.
-    private: std::map<unsigned int, math::Pose3d> localPoses;
+    private: EntityMap<math::Pose3d> localPoses;
 
     /// \brief Map of visual id to visual pointers.
-    private: std::map<unsigned int, rendering::VisualPtr::weak_type> visuals;
+    private: EntityMap<rendering::VisualPtr::weak_type> visuals;
 
     /// \brief Map of light id to light pointers.
-    private: std::map<unsigned int, rendering::LightPtr::weak_type> lights;
+    private: EntityMap<rendering::LightPtr::weak_type> lights;
+
+    /// \brief Latest poses of entities which aren't created yet, applied
+    /// when they are. Only accessed by the render thread.
+    private: PendingPoses pendingPoses{10000u, std::chrono::seconds(5)};
+
+    /// \brief Number of pose msgs received
+    private: std::atomic<uint64_t> poseMsgs{0u};
+
+    /// \brief Content hash of the models and lights of the scene msgs,
+    /// including queued models
+    private: SceneContents contents;
+
+    /// \brief Materials shared by the visuals, keyed by the material msg and
+    /// the transparency
+    private: std::unordered_map<std::string, SharedMaterial> materials;
+
+    /// \brief Keys of the shared materials, by material name
+    private: std::unordered_map<std::string, std::string> materialKeys;
+
+    /// \brief Mesh descriptors shared by the visuals, keyed by the mesh file,
+    /// submesh and centering
+    private: std::unordered_map<std::string, rendering::MeshDescriptor> meshes;
+
+    /// \brief Meshes loaded by the loading thread, by mesh file. The mesh
+    /// manager isn't thread-safe, so only the loading thread uses it.
+    private: std::unordered_map<std::string, const common::Mesh *>
+        loadedMeshes;
+
+    /// \brief Scene and deletion msgs waiting for the loading thread
+    private: std::deque<SceneUpdate> loadQueue;
+
+    /// \brief Scene and deletion msgs ready to be applied by the render
+    /// thread
+    private: std::vector<SceneUpdate> readyUpdates;
+
+    /// \brief Notified when msgs are added to the loading queue
+    private: std::condition_variable loadCv;
+
+    /// \brief Set to stop the loading thread
+    private: bool stopLoading = false;
+
+    /// \brief Thread parsing the meshes of the scene msgs
+    private: std::thread loadThread;
+
+    /// \brief Called when poses are received or scene msgs are ready, to
+    /// wake the render thread up
+    private: std::function<void()> wake;
 
-    /// Entities to be deleted
-    private: std::vector<unsigned int> toDeleteEntities;
+    /// \brief Models of loaded scene msgs which haven't been created yet.
+    /// Only accessed by the render thread.
+    private: std::deque<msgs::Model> pendingModels;
 
-    /// \brief Keeps the a list of unprocessed scene messages
-    private: std::vector<msgs::Scene> sceneMsgs;
+    /// \brief Time spent creating models per frame
+    private: std::chrono::steady_clock::duration loadBudget =
+        std::chrono::milliseconds(10);
 
     /// \brief Transport node for making service request and subscribing to
     /// pose topic
@@ -206,6 +441,9 @@ namespace plugins
     /// \brief Flag to indicate if mouse event is dirty
     public: bool mouseDirty = false;
 
+    /// \brief Called on new mouse events, to wake the render thread up
+    public: std::function<void()> wake;
+
     /// \brief Mouse event
     public: common::MouseEvent mouseEvent;
 
@@ -229,6 +467,87 @@ namespace plugins
 
     /// \brief View control focus target
     public: math::Vector3d target;
+
+    /// \brief Time when the last frame was rendered
+    public: std::chrono::steady_clock::time_point lastRenderTime;
+
+    /// \brief Scale of the render texture relative to the item size, set
+    /// by the adaptive resolution
+    public: double renderScale = 1.0;
+
+    /// \brief Current anti-aliasing level, lowered by the adaptive
+    /// resolution
+    public: unsigned int antiAliasing = 8u;
+
+    /// \brief Get a GPU timer which isn't waiting for its result, creating
+    /// the timers on the first call. The render context must be current.
+    /// \return Timer, null if both timers are waiting or timer queries
+    /// aren't supported
+    public: QOpenGLTimerQuery *FreeGpuTimer();
+
+    /// \brief Read the GPU time of the oldest timed frame, without waiting
+    /// for the GPU
+    /// \param[out] _seconds GPU time of the frame
+    /// \return False if no result is available yet
+    public: bool ReadGpuTime(double &_seconds);
+
+    /// \brief Timers of the GPU time of the camera updates. Their results
+    /// are read a frame or more later, so the render thread doesn't wait
+    /// for the GPU.
+    public: QOpenGLTimerQuery gpuTimers[2];
+
+    /// \brief True for the timers whose result hasn't been read yet
+    public: bool gpuTimerPending[2] = {false, false};
+
+    /// \brief Timer started by the next timed frame
+    public: int nextGpuTimer = 0;
+
+    /// \brief True once the creation of the timers was attempted
+    public: bool gpuTimersCreated = false;
+
+    /// \brief True if the timers were created
+    public: bool gpuTimersSupported = false;
+
+    /// \brief Smoothed GPU time taken to render a frame, in seconds
+    public: double frameTime = 0.0;
+
+    /// \brief Frames rendered since the resolution was last adapted
+    public: int framesSinceAdapt = 0;
+
+    /// \brief Time spent updating the scene from the msgs
+    public: StageTimer sceneTimer;
+
+    /// \brief Time spent handling mouse events
+    public: StageTimer mouseTimer;
+
+    /// \brief Time spent rendering the camera
+    public: StageTimer cameraTimer;
+
+    /// \brief Time between handing a texture over and being asked for the
+    /// next frame
+    public: StageTimer handoffTimer;
+
+    /// \brief Time taken by whole frames
+    public: StageTimer frameTimer;
+
+    /// \brief Time when Render() last handed a texture over, zero while
+    /// waiting for a change
+    public: std::chrono::steady_clock::time_point frameEndTime;
+
+    /// \brief Time when the statistics were last published
+    public: std::chrono::steady_clock::time_point statsTime;
+
+    /// \brief Scene counters when the statistics were last published
+    public: SceneStats lastStats;
+
+    /// \brief Frames rendered since the statistics were last published
+    public: int statsFrames = 0;
+
+    /// \brief Node to publish the statistics
+    public: transport::Node node;
+
+    /// \brief Publisher of the statistics
+    public: transport::Node::Publisher statsPub;
   };
 
   /// \brief Private data class for RenderWindowItem
@@ -242,6 +561,9 @@ namespace plugins
 
     //// \brief List of threads
     public: static QList<QThread *> threads;
+
+    /// \brief Latest statistics text of the render thread
+    public: QString statsText;
   };
 
   /// \brief Private data class for Scene3D
@@ -273,6 +595,19 @@ SceneManager::SceneManager(const std::string &_service,
   this->Load(_service, _poseTopic, _deletionTopic, _sceneTopic, _scene);
 }
 
+/////////////////////////////////////////////////
+SceneManager::~SceneManager()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stopLoading = true;
+  }
+  this->loadCv.notify_all();
+
+  if (this->loadThread.joinable())
+    this->loadThread.join();
+}
+
 /////////////////////////////////////////////////
 void SceneManager::Load(const std::string &_service,
                         const std::string &_poseTopic,
@@ -285,6 +620,9 @@ void SceneManager::Load(const std::string &_service,
   this->deletionTopic = _deletionTopic;
   this->sceneTopic = _sceneTopic;
   this->scene = _scene;
+
+  if (!this->loadThread.joinable())
+    this->loadThread = std::thread(&SceneManager::RunLoadThread, this);
 }
 
 /////////////////////////////////////////////////
@@ -313,99 +651,233 @@ void SceneManager::Request()
 /////////////////////////////////////////////////
 void SceneManager::OnPoseVMsg(const msgs::Pose_V &_msg)
 {
-  std::lock_guard<std::mutex> lock(this->mutex);
-  for (int i = 0; i < _msg.pose_size(); ++i)
+  std::lock_guard<std::mutex> lock(this->poseMutex);
+  auto &poses = this->poses.BeginWrite();
+  poses.Reserve(poses.Size() + static_cast<std::size_t>(_msg.pose_size()));
+  for (const auto &poseMsg : _msg.pose())
   {
-    math::Pose3d pose = msgs::Convert(_msg.pose(i));
+    const auto &position = poseMsg.position();
+    const auto &orientation = poseMsg.orientation();
+
+    auto &pose = poses[poseMsg.id()];
+    pose.position[0] = position.x();
+    pose.position[1] = position.y();
+    pose.position[2] = position.z();
+    pose.orientation[0] = orientation.w();
+    pose.orientation[1] = orientation.x();
+    pose.orientation[2] = orientation.y();
+    pose.orientation[3] = orientation.z();
+  }
+  this->poses.EndWrite();
+  this->poseMsgs.fetch_add(1, std::memory_order_relaxed);
+
+  if (this->wake)
+    this->wake();
+}
 
-    // apply additional local poses if available
-    const auto it = this->localPoses.find(_msg.pose(i).id());
-    if (it != this->localPoses.end())
+/////////////////////////////////////////////////
+void SceneManager::OnDeletionMsg(const msgs::UInt32_V &_msg)
+{
+  SceneUpdate update;
+  update.deletions.assign(_msg.data().begin(), _msg.data().end());
+  this->QueueUpdate(std::move(update));
+}
+
+/////////////////////////////////////////////////
+void SceneManager::QueueUpdate(SceneUpdate &&_update)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->loadQueue.push_back(std::move(_update));
+  }
+  this->loadCv.notify_one();
+}
+
+/////////////////////////////////////////////////
+void SceneManager::RunLoadThread()
+{
+  while (true)
+  {
+    SceneUpdate update;
     {
-      pose = pose * it->second;
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->loadCv.wait(lock, [this]
+          {
+            return this->stopLoading || !this->loadQueue.empty();
+          });
+      if (this->stopLoading)
+        return;
+
+      update = std::move(this->loadQueue.front());
+      this->loadQueue.pop_front();
     }
 
-    this->poses[_msg.pose(i).id()] = pose;
+    // Parse the mesh files here, and hand the meshes to the render thread
+    // with the scene
+    for (const auto &model : update.scene.model())
+    {
+      PreloadMeshes(model, update.meshes);
+      update.modelHashes.push_back(ContentHash(model));
+    }
+    for (const auto &light : update.scene.light())
+      update.lightHashes.push_back(ContentHash(light));
+
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->readyUpdates.push_back(std::move(update));
+    }
+
+    if (this->wake)
+      this->wake();
   }
 }
 
 /////////////////////////////////////////////////
-void SceneManager::OnDeletionMsg(const msgs::UInt32_V &_msg)
+void SceneManager::SetWakeCallback(const std::function<void()> &_wake)
 {
-  std::lock_guard<std::mutex> lock(this->mutex);
-  std::copy(_msg.data().begin(), _msg.data().end(),
-            std::back_inserter(this->toDeleteEntities));
+  this->wake = _wake;
 }
 
 /////////////////////////////////////////////////
-void SceneManager::Update()
+void SceneManager::PreloadMeshes(const msgs::Model &_msg,
+    std::unordered_map<std::string, const common::Mesh *> &_meshes)
 {
-  // process msgs
-  std::lock_guard<std::mutex> lock(this->mutex);
+  auto meshManager = common::MeshManager::Instance();
+  for (const auto &link : _msg.link())
+  {
+    for (const auto &visual : link.visual())
+    {
+      if (!visual.has_geometry() || !visual.geometry().has_mesh())
+        continue;
+
+      const auto &filename = visual.geometry().mesh().filename();
+      if (!filename.empty() && _meshes.find(filename) == _meshes.end())
+        _meshes[filename] = meshManager->Load(filename);
+    }
+  }
+
+  for (const auto &model : _msg.model())
+    PreloadMeshes(model, _meshes);
+}
 
-  for (const auto &msg : this->sceneMsgs)
+/////////////////////////////////////////////////
+bool SceneManager::Update()
+{
+  // take the msgs whose meshes are loaded, so the transport and loading
+  // threads aren't blocked while the scene is created
+  std::vector<SceneUpdate> updates;
   {
-    this->LoadScene(msg);
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::swap(updates, this->readyUpdates);
   }
-  this->sceneMsgs.clear();
 
-  for (const auto &entity : this->toDeleteEntities)
+  for (const auto &update : updates)
   {
-    this->DeleteEntity(entity);
+    // kept for the models created later, a mesh which failed to load may
+    // have been fixed since
+    for (const auto &mesh : update.meshes)
+      this->loadedMeshes[mesh.first] = mesh.second;
+
+    this->LoadScene(update);
+
+    if (update.deletions.empty())
+      continue;
+
+    // don't create models deleted before their turn came
+    if (!this->pendingModels.empty())
+    {
+      std::unordered_set<unsigned int> deleted(update.deletions.begin(),
+          update.deletions.end());
+      this->pendingModels.erase(std::remove_if(this->pendingModels.begin(),
+          this->pendingModels.end(), [&deleted](const msgs::Model &_model)
+          {
+            return deleted.count(_model.id()) > 0;
+          }), this->pendingModels.end());
+    }
+
+    for (const auto &entity : update.deletions)
+    {
+      this->DeleteEntity(entity);
+    }
   }
-  this->toDeleteEntities.clear();
 
+  // keep changing while models are being created
+  bool changed = !updates.empty() || !this->pendingModels.empty();
+  this->LoadPendingModels();
+
+  auto now = std::chrono::steady_clock::now();
+  this->pendingPoses.Expire(now);
 
-  for (auto pIt = this->poses.begin(); pIt != this->poses.end();)
+  auto poses = this->poses.Read();
+  if (!poses)
+    return changed;
+
+  for (std::size_t slot = 0; slot < poses->Size(); ++slot)
   {
-    auto vIt = this->visuals.find(pIt->first);
-    if (vIt != this->visuals.end())
+    auto id = poses->Id(slot);
+    const auto &raw = poses->Value(slot);
+    math::Pose3d pose(raw.position[0], raw.position[1], raw.position[2],
+        raw.orientation[0], raw.orientation[1], raw.orientation[2],
+        raw.orientation[3]);
+
+    auto visualPtr = this->visuals.Find(id);
+    if (visualPtr)
     {
-      auto visual = vIt->second.lock();
+      auto visual = visualPtr->lock();
       if (visual)
       {
-        visual->SetLocalPose(pIt->second);
+        // apply additional local poses if available
+        const auto localPose = this->localPoses.Find(id);
+        if (localPose)
+          pose = pose * *localPose;
+        visual->SetLocalPose(pose);
       }
       else
       {
-        this->visuals.erase(vIt);
+        this->visuals.Erase(id);
       }
-      this->poses.erase(pIt++);
+      continue;
     }
-    else
+
+    auto lightPtr = this->lights.Find(id);
+    if (lightPtr)
     {
-      auto lIt = this->lights.find(pIt->first);
-      if (lIt != this->lights.end())
-      {
-        auto light = lIt->second.lock();
-        if (light)
-        {
-          light->SetLocalPose(pIt->second);
-        }
-        else
-        {
-          this->lights.erase(lIt);
-        }
-        this->poses.erase(pIt++);
-      }
+      auto light = lightPtr->lock();
+      if (light)
+        light->SetLocalPose(pose);
       else
-      {
-        ++pIt;
-      }
+        this->lights.Erase(id);
+      continue;
     }
+
+    // the pose msg arrived before the scene msg, or the entity is still
+    // waiting to be created
+    this->pendingPoses.Keep(id, pose, now);
   }
 
-  // Note we are clearing the pose msgs here but later on we may need to
-  // consider the case where pose msgs arrive before scene/visual msgs
-  this->poses.clear();
+  return changed || poses->Size() > 0;
 }
 
+/////////////////////////////////////////////////
+SceneStats SceneManager::Stats() const
+{
+  SceneStats stats;
+  stats.visuals = this->visuals.Size();
+  stats.lights = this->lights.Size();
+  stats.pendingPoses = this->pendingPoses.Size();
+  stats.pendingModels = this->pendingModels.size();
+  stats.poseMsgs = this->poseMsgs.load(std::memory_order_relaxed);
+  stats.coalescedPoseMsgs = this->poses.Coalesced();
+  stats.droppedPoses = this->pendingPoses.Dropped();
+  return stats;
+}
 
 /////////////////////////////////////////////////
 void SceneManager::OnSceneMsg(const msgs::Scene &_msg)
 {
-  std::lock_guard<std::mutex> lock(this->mutex);
-  this->sceneMsgs.push_back(_msg);
+  SceneUpdate update;
+  update.scene = _msg;
+  this->QueueUpdate(std::move(update));
 }
 
 /////////////////////////////////////////////////
@@ -418,10 +890,9 @@ void SceneManager::OnSceneSrvMsg(const msgs::Scene &_msg, const bool result)
     return;
   }
 
-  {
-    std::lock_guard<std::mutex> lock(this->mutex);
-    this->sceneMsgs.push_back(_msg);
-  }
+  SceneUpdate update;
+  update.scene = _msg;
+  this->QueueUpdate(std::move(update));
 
   if (!this->poseTopic.empty())
   {
@@ -471,35 +942,95 @@ void SceneManager::OnSceneSrvMsg(const msgs::Scene &_msg, const bool result)
   }
 }
 
-void SceneManager::LoadScene(const msgs::Scene &_msg)
+void SceneManager::LoadScene(const SceneUpdate &_update)
 {
+  const auto &msg = _update.scene;
   rendering::VisualPtr rootVis = this->scene->RootVisual();
 
-  // load models
-  for (int i = 0; i < _msg.model_size(); ++i)
+  // queue new and changed models, they are created over several frames
+  for (int i = 0; i < msg.model_size(); ++i)
   {
-    // Only add if it's not already loaded
-    if (this->visuals.find(_msg.model(i).id()) == this->visuals.end())
+    const auto &model = msg.model(i);
+    auto change = this->contents.Compare(model.id(), _update.modelHashes[i]);
+    if (change == ContentChange::UNCHANGED)
+      continue;
+
+    if (change == ContentChange::CHANGED)
     {
-      rendering::VisualPtr modelVis = this->LoadModel(_msg.model(i));
-      if (modelVis)
-        rootVis->AddChild(modelVis);
-      else
-        ignerr << "Failed to load model: " << _msg.model(i).name() << std::endl;
+      this->RemovePendingModel(model.id());
+      this->DeleteEntity(model.id());
     }
+    this->contents.Set(model.id(), _update.modelHashes[i]);
+    this->pendingModels.push_back(model);
   }
 
-  // load lights
-  for (int i = 0; i < _msg.light_size(); ++i)
+  // load new and changed lights
+  for (int i = 0; i < msg.light_size(); ++i)
   {
-    if (this->lights.find(_msg.light(i).id()) == this->lights.end())
+    const auto &lightMsg = msg.light(i);
+    auto change =
+        this->contents.Compare(lightMsg.id(), _update.lightHashes[i]);
+    if (change == ContentChange::UNCHANGED)
+      continue;
+
+    if (change == ContentChange::CHANGED)
+      this->DeleteEntity(lightMsg.id());
+
+    rendering::LightPtr light = this->LoadLight(lightMsg);
+    if (light)
     {
-      rendering::LightPtr light = this->LoadLight(_msg.light(i));
-      if (light)
-        rootVis->AddChild(light);
+      rootVis->AddChild(light);
+      this->contents.Set(lightMsg.id(), _update.lightHashes[i]);
+    }
+    else
+    {
+      ignerr << "Failed to load light: " << lightMsg.name() << std::endl;
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+void SceneManager::RemovePendingModel(const unsigned int _id)
+{
+  this->pendingModels.erase(std::remove_if(this->pendingModels.begin(),
+      this->pendingModels.end(), [_id](const msgs::Model &_model)
+      {
+        return _model.id() == _id;
+      }), this->pendingModels.end());
+}
+
+/////////////////////////////////////////////////
+void SceneManager::LoadPendingModels()
+{
+  if (this->pendingModels.empty())
+    return;
+
+  rendering::VisualPtr rootVis = this->scene->RootVisual();
+  auto start = std::chrono::steady_clock::now();
+  while (!this->pendingModels.empty())
+  {
+    const auto &model = this->pendingModels.front();
+
+    // Only add if it's not already loaded
+    if (!this->visuals.Find(model.id()))
+    {
+      rendering::VisualPtr modelVis = this->LoadModel(model);
+      if (modelVis)
+      {
+        rootVis->AddChild(modelVis);
+      }
       else
-        ignerr << "Failed to load light: " << _msg.light(i).name() << std::endl;
+      {
+        ignerr << "Failed to load model: " << model.name() << std::endl;
+
+        // load it again when it's republished
+        this->contents.Erase(model.id());
+      }
     }
+    this->pendingModels.pop_front();
+
+    if (std::chrono::steady_clock::now() - start > this->loadBudget)
+      break;
   }
 }
 
@@ -511,6 +1042,10 @@ rendering::VisualPtr SceneManager::LoadModel(const msgs::Model &_msg)
     modelVis->SetLocalPose(msgs::Convert(_msg.pose()));
   this->visuals[_msg.id()] = modelVis;
 
+  math::Pose3d pose;
+  if (this->pendingPoses.Take(_msg.id(), pose))
+    modelVis->SetLocalPose(pose);
+
   // load links
   for (int i = 0; i < _msg.link_size(); ++i)
   {
@@ -543,6 +1078,10 @@ rendering::VisualPtr SceneManager::LoadLink(const msgs::Link &_msg)
     linkVis->SetLocalPose(msgs::Convert(_msg.pose()));
   this->visuals[_msg.id()] = linkVis;
 
+  math::Pose3d pose;
+  if (this->pendingPoses.Take(_msg.id(), pose))
+    linkVis->SetLocalPose(pose);
+
   // load visuals
   for (int i = 0; i < _msg.visual_size(); ++i)
   {
@@ -580,7 +1119,10 @@ rendering::VisualPtr SceneManager::LoadVisual(const msgs::Visual &_msg)
   rendering::GeometryPtr geom =
       this->LoadGeometry(_msg.geometry(), scale, localPose);
 
-  if (_msg.has_pose())
+  math::Pose3d pose;
+  if (this->pendingPoses.Take(_msg.id(), pose))
+    visualVis->SetLocalPose(pose * localPose);
+  else if (_msg.has_pose())
     visualVis->SetLocalPose(msgs::Convert(_msg.pose()) * localPose);
   else
     visualVis->SetLocalPose(localPose);
@@ -593,42 +1135,22 @@ rendering::VisualPtr SceneManager::LoadVisual(const msgs::Visual &_msg)
     visualVis->AddGeometry(geom);
     visualVis->SetLocalScale(scale);
 
-    // set material
-    rendering::MaterialPtr material{nullptr};
-    if (_msg.has_material())
-    {
-      material = this->LoadMaterial(_msg.material());
-    }
     // Don't set a default material for meshes because they
     // may have their own
     // TODO(anyone) support overriding mesh material
-    else if (_msg.geometry().has_mesh())
+    if (!_msg.has_material() && _msg.geometry().has_mesh())
     {
-      material = geom->Material();
+      rendering::MaterialPtr material = this->UniqueMaterial(geom);
+      material->SetTransparency(_msg.transparency());
+      material->SetRoughness(0.3f);
+      material->SetMetalness(0.3f);
+      geom->SetMaterial(material);
     }
     else
     {
-      // create default material
-      material = this->scene->Material("ign-grey");
-      if (!material)
-      {
-        material = this->scene->CreateMaterial("ign-grey");
-        material->SetAmbient(0.3, 0.3, 0.3);
-        material->SetDiffuse(0.7, 0.7, 0.7);
-        material->SetSpecular(1.0, 1.0, 1.0);
-        material->SetRoughness(0.2f);
-        material->SetMetalness(1.0f);
-      }
+      // Visuals with identical materials share them
+      geom->SetMaterial(this->CachedMaterial(_msg), false);
     }
-
-    material->SetTransparency(_msg.transparency());
-
-    // TODO(anyone) Get roughness and metalness from message instead
-    // of giving a default value.
-    material->SetRoughness(0.3f);
-    material->SetMetalness(0.3f);
-
-    geom->SetMaterial(material);
   }
   else
   {
@@ -692,15 +1214,33 @@ rendering::GeometryPtr SceneManager::LoadGeometry(const msgs::Geometry &_msg,
       ignerr << "Mesh geometry missing filename" << std::endl;
       return geom;
     }
-    rendering::MeshDescriptor descriptor;
+    // Visuals of the same mesh share its descriptor. The render engine
+    // shares the mesh data between the geometries created from it.
+    const auto &meshMsg = _msg.mesh();
+    auto key = meshMsg.filename() + '\n' + meshMsg.submesh() + '\n' +
+        (meshMsg.center_submesh() ? '1' : '0');
+    auto it = this->meshes.find(key);
+    if (it == this->meshes.end())
+    {
+      rendering::MeshDescriptor descriptor;
 
-    // Assume absolute path to mesh file
-    descriptor.meshName = _msg.mesh().filename();
+      // Assume absolute path to mesh file
+      descriptor.meshName = meshMsg.filename();
+      descriptor.subMeshName = meshMsg.submesh();
+      descriptor.centerSubMesh = meshMsg.center_submesh();
 
-    ignition::common::MeshManager* meshManager =
-        ignition::common::MeshManager::Instance();
-    descriptor.mesh = meshManager->Load(descriptor.meshName);
-    geom = this->scene->CreateMesh(descriptor);
+      // loaded by the loading thread, as the mesh manager isn't thread-safe
+      auto loaded = this->loadedMeshes.find(descriptor.meshName);
+      if (loaded == this->loadedMeshes.end() || !loaded->second)
+      {
+        ignerr << "Unable to load mesh [" << descriptor.meshName << "]"
+               << std::endl;
+        return geom;
+      }
+      descriptor.mesh = loaded->second;
+      it = this->meshes.emplace(key, descriptor).first;
+    }
+    geom = this->scene->CreateMesh(it->second);
 
     scale = msgs::Convert(_msg.mesh().scale());
   }
@@ -713,6 +1253,111 @@ rendering::GeometryPtr SceneManager::LoadGeometry(const msgs::Geometry &_msg,
   return geom;
 }
 
+/////////////////////////////////////////////////
+rendering::MaterialPtr SceneManager::CachedMaterial(const msgs::Visual &_msg)
+{
+  // The fields of the material msg and the transparency of the visual
+  // identify the material
+  std::string key;
+  if (_msg.has_material())
+    key = _msg.material().SerializeAsString();
+  float transparency = _msg.transparency();
+  key.append(reinterpret_cast<const char *>(&transparency),
+      sizeof(transparency));
+
+  auto it = this->materials.find(key);
+  if (it != this->materials.end())
+  {
+    it->second.users++;
+    return it->second.material;
+  }
+
+  rendering::MaterialPtr material{nullptr};
+  if (_msg.has_material())
+  {
+    material = this->LoadMaterial(_msg.material());
+  }
+  else
+  {
+    // create default material
+    material = this->scene->Material("ign-grey");
+    if (!material)
+    {
+      material = this->scene->CreateMaterial("ign-grey");
+      material->SetAmbient(0.3, 0.3, 0.3);
+      material->SetDiffuse(0.7, 0.7, 0.7);
+      material->SetSpecular(1.0, 1.0, 1.0);
+      material->SetRoughness(0.2f);
+      material->SetMetalness(1.0f);
+    }
+    material = material->Clone();
+  }
+
+  material->SetTransparency(transparency);
+
+  // TODO(anyone) Get roughness and metalness from message instead
+  // of giving a default value.
+  material->SetRoughness(0.3f);
+  material->SetMetalness(0.3f);
+
+  this->materials[key] = {material, 1u};
+  this->materialKeys[material->Name()] = key;
+  return material;
+}
+
+/////////////////////////////////////////////////
+void SceneManager::ReleaseMaterial(const rendering::MaterialPtr &_material)
+{
+  auto keyIt = this->materialKeys.find(_material->Name());
+  if (keyIt == this->materialKeys.end())
+    return;
+
+  auto it = this->materials.find(keyIt->second);
+  if (it != this->materials.end() && --it->second.users > 0u)
+    return;
+
+  // the geometries don't own shared materials, so they aren't destroyed
+  // with them
+  this->scene->DestroyMaterial(_material);
+  if (it != this->materials.end())
+    this->materials.erase(it);
+  this->materialKeys.erase(keyIt);
+}
+
+/////////////////////////////////////////////////
+rendering::MaterialPtr SceneManager::UniqueMaterial(
+    const rendering::GeometryPtr &_geom)
+{
+  rendering::MaterialPtr material = _geom->Material();
+  if (!material || !this->materialKeys.count(material->Name()))
+    return material;
+
+  // the geometry owns the clone
+  _geom->SetMaterial(material, true);
+  this->ReleaseMaterial(material);
+  return _geom->Material();
+}
+
+/////////////////////////////////////////////////
+void SceneManager::SharedMaterials(const rendering::VisualPtr &_visual,
+    std::vector<rendering::MaterialPtr> &_materials) const
+{
+  for (unsigned int i = 0; i < _visual->GeometryCount(); ++i)
+  {
+    rendering::MaterialPtr material = _visual->GeometryByIndex(i)->Material();
+    if (material && this->materialKeys.count(material->Name()))
+      _materials.push_back(material);
+  }
+
+  for (unsigned int i = 0; i < _visual->ChildCount(); ++i)
+  {
+    auto child = std::dynamic_pointer_cast<rendering::Visual>(
+        _visual->ChildByIndex(i));
+    if (child)
+      this->SharedMaterials(child, _materials);
+  }
+}
+
 /////////////////////////////////////////////////
 rendering::MaterialPtr SceneManager::LoadMaterial(const msgs::Material &_msg)
 {
@@ -788,6 +1433,10 @@ rendering::LightPtr SceneManager::LoadLight(const msgs::Light &_msg)
 
   light->SetCastShadows(_msg.cast_shadows());
 
+  math::Pose3d pose;
+  if (this->pendingPoses.Take(_msg.id(), pose))
+    light->SetLocalPose(pose);
+
   this->lights[_msg.id()] = light;
   return light;
 }
@@ -795,23 +1444,35 @@ rendering::LightPtr SceneManager::LoadLight(const msgs::Light &_msg)
 /////////////////////////////////////////////////
 void SceneManager::DeleteEntity(const unsigned int _entity)
 {
-  if (this->visuals.find(_entity) != this->visuals.end())
+  this->localPoses.Erase(_entity);
+  this->contents.Erase(_entity);
+  this->pendingPoses.Erase(_entity);
+
+  auto visualPtr = this->visuals.Find(_entity);
+  if (visualPtr)
   {
-    auto visual = this->visuals[_entity].lock();
+    auto visual = visualPtr->lock();
     if (visual)
     {
+      std::vector<rendering::MaterialPtr> materials;
+      this->SharedMaterials(visual, materials);
       this->scene->DestroyVisual(visual, true);
+      for (const auto &material : materials)
+        this->ReleaseMaterial(material);
     }
-    this->visuals.erase(_entity);
+    this->visuals.Erase(_entity);
+    return;
   }
-  else if (this->lights.find(_entity) != this->lights.end())
+
+  auto lightPtr = this->lights.Find(_entity);
+  if (lightPtr)
   {
-    auto light = this->lights[_entity].lock();
+    auto light = lightPtr->lock();
     if (light)
     {
       this->scene->DestroyLight(light, true);
     }
-    this->lights.erase(_entity);
+    this->lights.Erase(_entity);
   }
 }
 
@@ -828,28 +1489,73 @@ IgnRenderer::~IgnRenderer()
 }
 
 /////////////////////////////////////////////////
-void IgnRenderer::Render()
+bool IgnRenderer::Render()
 {
+  auto frameStart = std::chrono::steady_clock::now();
+  auto elapsedMs = [](const std::chrono::steady_clock::time_point &_start)
+  {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - _start).count();
+  };
+
+  if (this->dataPtr->frameEndTime.time_since_epoch().count() != 0)
+  {
+    this->dataPtr->handoffTimer.Add(std::chrono::duration<double, std::milli>(
+        frameStart - this->dataPtr->frameEndTime).count());
+  }
+
+  bool dirty = this->textureDirty;
   if (this->textureDirty)
   {
-    this->dataPtr->camera->SetImageWidth(this->textureSize.width());
-    this->dataPtr->camera->SetImageHeight(this->textureSize.height());
-    this->dataPtr->camera->SetAspectRatio(this->textureSize.width() /
-        this->textureSize.height());
-    // setting the size should cause the render texture to be rebuilt
-    this->dataPtr->camera->PreRender();
-    this->textureId = this->dataPtr->camera->RenderTextureGLId();
+    this->UpdateRenderTexture();
     this->textureDirty = false;
   }
 
   // update the scene
-  this->dataPtr->sceneManager.Update();
+  auto stageStart = std::chrono::steady_clock::now();
+  dirty = this->dataPtr->sceneManager.Update() || dirty;
+  this->dataPtr->sceneTimer.Add(elapsedMs(stageStart));
 
   // view control
-  this->HandleMouseEvent();
+  stageStart = std::chrono::steady_clock::now();
+  dirty = this->HandleMouseEvent() || dirty;
+  this->dataPtr->mouseTimer.Add(elapsedMs(stageStart));
+
+  // skip the frame if nothing changed, but still render once in a while
+  // for changes made by other plugins
+  auto now = std::chrono::steady_clock::now();
+  bool render = !this->renderOnDemand || dirty ||
+      now - this->dataPtr->lastRenderTime >=
+      std::chrono::duration<double>(this->maxIdleInterval);
 
   // update and render to texture
-  this->dataPtr->camera->Update();
+  if (render)
+  {
+    // the CPU only submits the frame, the adaptive resolution needs the time
+    // the GPU takes to render it
+    QOpenGLTimerQuery *gpuTimer = nullptr;
+    if (this->adaptiveResolution)
+    {
+      gpuTimer = this->dataPtr->FreeGpuTimer();
+      if (!this->dataPtr->gpuTimersSupported)
+        this->adaptiveResolution = false;
+    }
+
+    if (gpuTimer)
+      gpuTimer->begin();
+    this->dataPtr->camera->Update();
+    if (gpuTimer)
+      gpuTimer->end();
+    this->dataPtr->lastRenderTime = now;
+
+    this->dataPtr->cameraTimer.Add(elapsedMs(now));
+    this->dataPtr->frameTimer.Add(elapsedMs(frameStart));
+    this->dataPtr->statsFrames++;
+
+    double gpuTime = 0.0;
+    if (this->adaptiveResolution && this->dataPtr->ReadGpuTime(gpuTime))
+      this->AdaptResolution(gpuTime);
+  }
 
   if (ignition::gui::App())
   {
@@ -857,14 +1563,261 @@ void IgnRenderer::Render()
         ignition::gui::App()->findChild<ignition::gui::MainWindow *>(),
         new gui::events::Render());
   }
+
+  this->UpdateStats();
+
+  // without a new texture, the next frame comes from a wake-up and not from
+  // TextureInUse, so the wait isn't a handoff
+  if (render)
+    this->dataPtr->frameEndTime = std::chrono::steady_clock::now();
+  else
+    this->dataPtr->frameEndTime = std::chrono::steady_clock::time_point();
+  return render;
+}
+
+/////////////////////////////////////////////////
+void IgnRenderer::UpdateStats()
+{
+  if (!this->showStats && !this->dataPtr->statsPub)
+    return;
+
+  // once per second
+  auto now = std::chrono::steady_clock::now();
+  double period = std::chrono::duration<double>(
+      now - this->dataPtr->statsTime).count();
+  if (period < 1.0)
+    return;
+
+  auto stats = this->dataPtr->sceneManager.Stats();
+  const auto &last = this->dataPtr->lastStats;
+  bool first = this->dataPtr->statsTime.time_since_epoch().count() == 0;
+  double fps = first ? 0.0 : this->dataPtr->statsFrames / period;
+  double poseRate = first ? 0.0 : (stats.poseMsgs - last.poseMsgs) / period;
+  auto coalesced = stats.coalescedPoseMsgs - last.coalescedPoseMsgs;
+  auto dropped = stats.droppedPoses - last.droppedPoses;
+
+  const std::vector<std::pair<std::string, const StageTimer *>> stages{
+      {"scene", &this->dataPtr->sceneTimer},
+      {"mouse", &this->dataPtr->mouseTimer},
+      {"camera", &this->dataPtr->cameraTimer},
+      {"handoff", &this->dataPtr->handoffTimer},
+      {"frame", &this->dataPtr->frameTimer}};
+
+  if (this->dataPtr->statsPub)
+  {
+    msgs::Param msg;
+    auto &params = *msg.mutable_params();
+    auto setDouble = [&params](const std::string &_name, double _value)
+    {
+      params[_name].set_type(msgs::Any::DOUBLE);
+      params[_name].set_double_value(_value);
+    };
+    auto setInt = [&params](const std::string &_name, uint64_t _value)
+    {
+      params[_name].set_type(msgs::Any::INT32);
+      params[_name].set_int_value(static_cast<int>(_value));
+    };
+
+    for (const auto &stage : stages)
+    {
+      setDouble(stage.first + "_p50_ms", stage.second->Percentile(50));
+      setDouble(stage.first + "_p95_ms", stage.second->Percentile(95));
+      setDouble(stage.first + "_max_ms", stage.second->Percentile(100));
+    }
+    setDouble("fps", fps);
+    setDouble("pose_msgs_per_s", poseRate);
+    setInt("visuals", stats.visuals);
+    setInt("lights", stats.lights);
+    setInt("pending_poses", stats.pendingPoses);
+    setInt("pending_models", stats.pendingModels);
+    setInt("coalesced_pose_msgs", coalesced);
+    setInt("dropped_poses", dropped);
+    this->dataPtr->statsPub.Publish(msg);
+  }
+
+  if (this->showStats)
+  {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(2);
+    text << "ms      p50    p95    max\n";
+    for (const auto &stage : stages)
+    {
+      text << std::left << std::setw(8) << stage.first << std::right
+           << std::setw(5) << stage.second->Percentile(50) << "  "
+           << std::setw(5) << stage.second->Percentile(95) << "  "
+           << std::setw(5) << stage.second->Percentile(100) << "\n";
+    }
+    text << std::setprecision(1)
+         << "fps " << fps << ", pose msgs/s " << poseRate << "\n"
+         << "visuals " << stats.visuals << ", lights " << stats.lights << "\n"
+         << "pending poses " << stats.pendingPoses << ", models "
+         << stats.pendingModels << "\n"
+         << "coalesced pose msgs " << coalesced << ", dropped poses "
+         << dropped;
+    this->statsText = QString::fromStdString(text.str());
+    this->statsReady = true;
+  }
+
+  this->dataPtr->lastStats = stats;
+  this->dataPtr->statsTime = now;
+  this->dataPtr->statsFrames = 0;
+}
+
+/////////////////////////////////////////////////
+int IgnRenderer::FrameDelay() const
+{
+  if (this->maxFrameRate <= 0)
+    return 0;
+
+  auto elapsed = std::chrono::steady_clock::now() -
+      this->dataPtr->lastRenderTime;
+  auto remaining = std::chrono::duration<double>(1.0 / this->maxFrameRate) -
+      elapsed;
+  if (remaining <= std::chrono::steady_clock::duration::zero())
+    return 0;
+
+  return static_cast<int>(std::ceil(
+      std::chrono::duration<double, std::milli>(remaining).count()));
+}
+
+/////////////////////////////////////////////////
+int IgnRenderer::IdleDelay() const
+{
+  auto elapsed = std::chrono::steady_clock::now() -
+      this->dataPtr->lastRenderTime;
+  auto remaining = std::chrono::duration<double>(this->maxIdleInterval) -
+      elapsed;
+  if (remaining <= std::chrono::steady_clock::duration::zero())
+    return 0;
+
+  return static_cast<int>(std::ceil(
+      std::chrono::duration<double, std::milli>(remaining).count()));
 }
 
 /////////////////////////////////////////////////
-void IgnRenderer::HandleMouseEvent()
+void IgnRenderer::UpdateRenderTexture()
+{
+  this->renderSize = QSize(
+      std::max(1, static_cast<int>(std::lround(
+          this->textureSize.width() * this->dataPtr->renderScale))),
+      std::max(1, static_cast<int>(std::lround(
+          this->textureSize.height() * this->dataPtr->renderScale))));
+
+  this->dataPtr->camera->SetImageWidth(this->renderSize.width());
+  this->dataPtr->camera->SetImageHeight(this->renderSize.height());
+  this->dataPtr->camera->SetAspectRatio(
+      static_cast<double>(this->textureSize.width()) /
+      this->textureSize.height());
+  this->dataPtr->camera->SetAntiAliasing(this->dataPtr->antiAliasing);
+  // setting the size and calling PreRender should cause the render texture to
+  //  be rebuilt
+  this->dataPtr->camera->PreRender();
+  this->textureId = this->dataPtr->camera->RenderTextureGLId();
+}
+
+/////////////////////////////////////////////////
+void IgnRenderer::AdaptResolution(double _frameTime)
+{
+  // smooth out single slow frames
+  auto &frameTime = this->dataPtr->frameTime;
+  frameTime = frameTime <= 0 ? _frameTime : 0.9 * frameTime + 0.1 * _frameTime;
+
+  // give the new resolution time to settle
+  if (++this->dataPtr->framesSinceAdapt < 30)
+    return;
+
+  double budget = 1.0 / (this->maxFrameRate > 0 ? this->maxFrameRate : 60.0);
+  auto &scale = this->dataPtr->renderScale;
+  auto &antiAliasing = this->dataPtr->antiAliasing;
+  bool changed = false;
+
+  // over budget: drop anti-aliasing first, then resolution
+  if (frameTime > budget)
+  {
+    if (antiAliasing > 0)
+    {
+      antiAliasing /= 2;
+      if (antiAliasing < 2)
+        antiAliasing = 0;
+      changed = true;
+    }
+    else if (scale > this->minRenderScale)
+    {
+      scale = std::max(this->minRenderScale, scale * 0.85);
+      changed = true;
+    }
+  }
+  // well within budget: restore resolution first, then anti-aliasing
+  else if (frameTime < budget * 0.5)
+  {
+    if (scale < 1.0)
+    {
+      scale = std::min(1.0, scale / 0.85);
+      changed = true;
+    }
+    else if (antiAliasing < this->antiAliasing)
+    {
+      antiAliasing = std::min(this->antiAliasing,
+          antiAliasing == 0 ? 2u : antiAliasing * 2);
+      changed = true;
+    }
+  }
+
+  if (!changed)
+    return;
+
+  // applied before the next frame, so the displayed texture is complete
+  this->textureDirty = true;
+  this->dataPtr->framesSinceAdapt = 0;
+  this->dataPtr->frameTime = 0.0;
+}
+
+/////////////////////////////////////////////////
+QOpenGLTimerQuery *IgnRendererPrivate::FreeGpuTimer()
+{
+  if (!this->gpuTimersCreated)
+  {
+    this->gpuTimersCreated = true;
+    this->gpuTimersSupported = this->gpuTimers[0].create() &&
+        this->gpuTimers[1].create();
+    if (!this->gpuTimersSupported)
+    {
+      ignwarn << "OpenGL timer queries aren't supported, disabling the "
+              << "adaptive resolution." << std::endl;
+    }
+  }
+
+  int i = this->nextGpuTimer;
+  if (!this->gpuTimersSupported || this->gpuTimerPending[i])
+    return nullptr;
+
+  this->gpuTimerPending[i] = true;
+  this->nextGpuTimer = 1 - i;
+  return &this->gpuTimers[i];
+}
+
+/////////////////////////////////////////////////
+bool IgnRendererPrivate::ReadGpuTime(double &_seconds)
+{
+  // the next timer to start is the oldest one if it's still pending
+  int i = this->nextGpuTimer;
+  if (!this->gpuTimerPending[i])
+    i = 1 - i;
+
+  if (!this->gpuTimerPending[i] || !this->gpuTimers[i].isResultAvailable())
+    return false;
+
+  this->gpuTimerPending[i] = false;
+  _seconds = this->gpuTimers[i].waitForResult() * 1e-9;
+  return true;
+}
+
+/////////////////////////////////////////////////
+bool IgnRenderer::HandleMouseEvent()
 {
   std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
   if (!this->dataPtr->mouseDirty)
-    return;
+    return false;
 
   this->dataPtr->viewControl.SetCamera(this->dataPtr->camera);
 
@@ -908,13 +1861,14 @@ void IgnRenderer::HandleMouseEvent()
       double distance = this->dataPtr->camera->WorldPosition().Distance(
           this->dataPtr->target);
       double amount = ((-this->dataPtr->drag.Y() /
-          static_cast<double>(this->dataPtr->camera->ImageHeight()))
+          static_cast<double>(this->textureSize.height()))
           * distance * tan(vfov/2.0) * 6.0);
       this->dataPtr->viewControl.Zoom(amount);
     }
   }
   this->dataPtr->drag = 0;
   this->dataPtr->mouseDirty = false;
+  return true;
 }
 
 /////////////////////////////////////////////////
@@ -949,14 +1903,9 @@ void IgnRenderer::Initialize()
   this->dataPtr->camera = scene->CreateCamera();
   root->AddChild(this->dataPtr->camera);
   this->dataPtr->camera->SetLocalPose(this->cameraPose);
-  this->dataPtr->camera->SetImageWidth(this->textureSize.width());
-  this->dataPtr->camera->SetImageHeight(this->textureSize.height());
-  this->dataPtr->camera->SetAntiAliasing(8);
   this->dataPtr->camera->SetHFOV(M_PI * 0.5);
-  // setting the size and calling PreRender should cause the render texture to
-  //  be rebuilt
-  this->dataPtr->camera->PreRender();
-  this->textureId = this->dataPtr->camera->RenderTextureGLId();
+  this->dataPtr->antiAliasing = this->antiAliasing;
+  this->UpdateRenderTexture();
 
   // Make service call to populate scene
   if (!this->sceneService.empty())
@@ -970,12 +1919,32 @@ void IgnRenderer::Initialize()
   // Ray Query
   this->dataPtr->rayQuery = this->dataPtr->camera->Scene()->CreateRayQuery();
 
+  // Statistics
+  if (!this->statsTopic.empty())
+  {
+    this->dataPtr->statsPub =
+        this->dataPtr->node.Advertise<msgs::Param>(this->statsTopic);
+    if (!this->dataPtr->statsPub)
+    {
+      ignerr << "Error advertising stats topic: " << this->statsTopic
+             << std::endl;
+    }
+  }
+
   this->initialized = true;
 }
 
 /////////////////////////////////////////////////
 void IgnRenderer::Destroy()
 {
+  // one of the timers may have been created even if the other failed
+  for (auto &timer : this->dataPtr->gpuTimers)
+  {
+    if (timer.isCreated())
+      timer.destroy();
+  }
+  this->dataPtr->gpuTimersSupported = false;
+
   auto engine = rendering::engine(this->engineName);
   if (!engine)
     return;
@@ -1002,15 +1971,25 @@ void IgnRenderer::NewMouseEvent(const common::MouseEvent &_e,
   this->dataPtr->mouseEvent = _e;
   this->dataPtr->drag += _drag;
   this->dataPtr->mouseDirty = true;
+
+  if (this->dataPtr->wake)
+    this->dataPtr->wake();
+}
+
+/////////////////////////////////////////////////
+void IgnRenderer::SetWakeCallback(const std::function<void()> &_wake)
+{
+  this->dataPtr->wake = _wake;
+  this->dataPtr->sceneManager.SetWakeCallback(_wake);
 }
 
 /////////////////////////////////////////////////
 math::Vector3d IgnRenderer::ScreenToScene(
     const math::Vector2i &_screenPos) const
 {
-  // Normalize point on the image
-  double width = this->dataPtr->camera->ImageWidth();
-  double height = this->dataPtr->camera->ImageHeight();
+  // Normalize point on the item, the image may be scaled down
+  double width = this->textureSize.width();
+  double height = this->textureSize.height();
 
   double nx = 2.0 * _screenPos.X() / width - 1.0;
   double ny = 1.0 - 2.0 * _screenPos.Y() / height;
@@ -1032,11 +2011,33 @@ math::Vector3d IgnRenderer::ScreenToScene(
 RenderThread::RenderThread()
 {
   RenderWindowItemPrivate::threads << this;
+
+  // child of the thread object, so it's moved to the render thread with it
+  this->idleTimer = new QTimer(this);
+  this->idleTimer->setSingleShot(true);
+  this->connect(this->idleTimer, &QTimer::timeout, this, &RenderThread::Wake);
+
+  this->frameTimer = new QTimer(this);
+  this->frameTimer->setSingleShot(true);
+  this->connect(this->frameTimer, &QTimer::timeout, this,
+      &RenderThread::RenderNext);
+
+  // called from the transport, loading and GUI threads. Only one call to
+  // Wake() is queued at a time.
+  this->ignRenderer.SetWakeCallback([this]
+  {
+    if (!this->wakePending.exchange(true))
+      QMetaObject::invokeMethod(this, "Wake", Qt::QueuedConnection);
+  });
 }
 
 /////////////////////////////////////////////////
 void RenderThread::RenderNext()
 {
+  // a queued frame after ShutDown() deleted the context
+  if (this->shutDown)
+    return;
+
   this->context->makeCurrent(this->surface);
 
   if (!this->ignRenderer.initialized)
@@ -1052,14 +2053,45 @@ void RenderThread::RenderNext()
     return;
   }
 
-  this->ignRenderer.Render();
+  // stay under the max frame rate
+  int delay = this->ignRenderer.FrameDelay();
+  if (delay > 0)
+  {
+    this->frameTimer->start(delay);
+    return;
+  }
+
+  if (!this->ignRenderer.Render())
+  {
+    // nothing changed, the displayed texture is still current. Wait for the
+    // scene, the poses or the mouse to change, or for the idle frame.
+    if (this->ignRenderer.statsReady)
+    {
+      this->ignRenderer.statsReady = false;
+      emit StatsReady(this->ignRenderer.statsText);
+    }
+    this->waiting = true;
+    this->idleTimer->start(std::max(1, this->ignRenderer.IdleDelay()));
+    return;
+  }
 
-  emit TextureReady(this->ignRenderer.textureId, this->ignRenderer.textureSize);
+  emit TextureReady(this->ignRenderer.textureId, this->ignRenderer.renderSize);
+
+  if (this->ignRenderer.statsReady)
+  {
+    this->ignRenderer.statsReady = false;
+    emit StatsReady(this->ignRenderer.statsText);
+  }
 }
 
 /////////////////////////////////////////////////
 void RenderThread::ShutDown()
 {
+  this->shutDown = true;
+  this->idleTimer->stop();
+  this->frameTimer->stop();
+  this->waiting = false;
+
   this->context->makeCurrent(this->surface);
 
   this->ignRenderer.Destroy();
@@ -1090,6 +2122,29 @@ void RenderThread::SizeChanged()
 
   this->ignRenderer.textureSize = QSize(item->width(), item->height());
   this->ignRenderer.textureDirty = true;
+  this->Resume();
+}
+
+/////////////////////////////////////////////////
+void RenderThread::Wake()
+{
+  this->wakePending = false;
+  if (this->shutDown)
+    return;
+
+  this->Resume();
+}
+
+/////////////////////////////////////////////////
+void RenderThread::Resume()
+{
+  // Otherwise a frame is already on its way, and it will see the change
+  if (!this->waiting)
+    return;
+
+  this->waiting = false;
+  this->idleTimer->stop();
+  this->RenderNext();
 }
 
 /////////////////////////////////////////////////
@@ -1197,6 +2252,9 @@ void RenderWindowItem::Ready()
       this->dataPtr->renderThread, &RenderThread::ShutDown,
       Qt::QueuedConnection);
 
+  this->connect(this->dataPtr->renderThread, &RenderThread::StatsReady,
+      this, &RenderWindowItem::SetStatsText, Qt::QueuedConnection);
+
   this->connect(this, &QQuickItem::widthChanged,
       this->dataPtr->renderThread, &RenderThread::SizeChanged);
   this->connect(this, &QQuickItem::heightChanged,
@@ -1327,6 +2385,63 @@ void RenderWindowItem::SetSceneTopic(const std::string &_topic)
   this->dataPtr->renderThread->ignRenderer.sceneTopic = _topic;
 }
 
+/////////////////////////////////////////////////
+void RenderWindowItem::SetRenderOnDemand(bool _onDemand)
+{
+  this->dataPtr->renderThread->ignRenderer.renderOnDemand = _onDemand;
+}
+
+/////////////////////////////////////////////////
+void RenderWindowItem::SetMaxIdleInterval(double _interval)
+{
+  this->dataPtr->renderThread->ignRenderer.maxIdleInterval = _interval;
+}
+
+/////////////////////////////////////////////////
+void RenderWindowItem::SetStatsTopic(const std::string &_topic)
+{
+  this->dataPtr->renderThread->ignRenderer.statsTopic = _topic;
+}
+
+/////////////////////////////////////////////////
+void RenderWindowItem::SetShowStats(bool _show)
+{
+  this->dataPtr->renderThread->ignRenderer.showStats = _show;
+}
+
+/////////////////////////////////////////////////
+QString RenderWindowItem::StatsText() const
+{
+  return this->dataPtr->statsText;
+}
+
+/////////////////////////////////////////////////
+void RenderWindowItem::SetStatsText(const QString &_text)
+{
+  this->dataPtr->statsText = _text;
+  emit this->StatsTextChanged();
+}
+
+/////////////////////////////////////////////////
+void RenderWindowItem::SetMaxFrameRate(double _rate)
+{
+  this->dataPtr->renderThread->ignRenderer.maxFrameRate = _rate;
+}
+
+/////////////////////////////////////////////////
+void RenderWindowItem::SetAntiAliasing(unsigned int _level)
+{
+  this->dataPtr->renderThread->ignRenderer.antiAliasing = _level;
+}
+
+/////////////////////////////////////////////////
+void RenderWindowItem::SetAdaptiveResolution(bool _adaptive,
+    double _minScale)
+{
+  this->dataPtr->renderThread->ignRenderer.adaptiveResolution = _adaptive;
+  this->dataPtr->renderThread->ignRenderer.minRenderScale = _minScale;
+}
+
 /////////////////////////////////////////////////
 Scene3D::Scene3D()
   : Plugin(), dataPtr(new Scene3DPrivate)
@@ -1430,6 +2545,92 @@ void Scene3D::LoadConfig(const tinyxml2::XMLElement *_pluginElem)
       std::string topic = elem->GetText();
       renderWindow->SetSceneTopic(topic);
     }
+
+    elem = _pluginElem->FirstChildElement("render_on_demand");
+    if (nullptr != elem && nullptr != elem->GetText())
+    {
+      bool onDemand = false;
+      elem->QueryBoolText(&onDemand);
+      renderWindow->SetRenderOnDemand(onDemand);
+    }
+
+    elem = _pluginElem->FirstChildElement("max_idle_interval");
+    if (nullptr != elem && nullptr != elem->GetText())
+    {
+      double interval = 1.0;
+      if (elem->QueryDoubleText(&interval) == tinyxml2::XML_SUCCESS &&
+          interval > 0)
+      {
+        renderWindow->SetMaxIdleInterval(interval);
+      }
+      else
+      {
+        ignwarn << "Invalid <max_idle_interval> [" << elem->GetText()
+                << "], it must be a positive number of seconds." << std::endl;
+      }
+    }
+
+    elem = _pluginElem->FirstChildElement("stats_topic");
+    if (nullptr != elem && nullptr != elem->GetText())
+    {
+      std::string topic = elem->GetText();
+      renderWindow->SetStatsTopic(topic);
+    }
+
+    elem = _pluginElem->FirstChildElement("show_stats");
+    if (nullptr != elem && nullptr != elem->GetText())
+    {
+      bool show = false;
+      elem->QueryBoolText(&show);
+      renderWindow->SetShowStats(show);
+      this->PluginItem()->setProperty("showStats", show);
+    }
+
+    elem = _pluginElem->FirstChildElement("max_frame_rate");
+    if (nullptr != elem && nullptr != elem->GetText())
+    {
+      double rate = 0.0;
+      if (elem->QueryDoubleText(&rate) == tinyxml2::XML_SUCCESS && rate >= 0)
+      {
+        renderWindow->SetMaxFrameRate(rate);
+      }
+      else
+      {
+        ignwarn << "Invalid <max_frame_rate> [" << elem->GetText()
+                << "], it must be a non-negative number of frames per "
+                << "second, 0 for no cap." << std::endl;
+      }
+    }
+
+    elem = _pluginElem->FirstChildElement("anti_aliasing");
+    if (nullptr != elem && nullptr != elem->GetText())
+    {
+      unsigned int level = 8u;
+      if (elem->QueryUnsignedText(&level) == tinyxml2::XML_SUCCESS)
+        renderWindow->SetAntiAliasing(level);
+      else
+        ignwarn << "Invalid <anti_aliasing> [" << elem->GetText() << "]"
+                << std::endl;
+    }
+
+    elem = _pluginElem->FirstChildElement("adaptive_resolution");
+    if (nullptr != elem && nullptr != elem->GetText())
+    {
+      bool adaptive = false;
+      elem->QueryBoolText(&adaptive);
+
+      double minScale = 0.5;
+      elem = _pluginElem->FirstChildElement("min_render_scale");
+      if (nullptr != elem && nullptr != elem->GetText() &&
+          (elem->QueryDoubleText(&minScale) != tinyxml2::XML_SUCCESS ||
+          minScale <= 0 || minScale > 1))
+      {
+        ignwarn << "Invalid <min_render_scale> [" << elem->GetText()
+                << "], it must be in (0, 1]. Using 0.5." << std::endl;
+        minScale = 0.5;
+      }
+      renderWindow->SetAdaptiveResolution(adaptive, minScale);
+    }
   }
 }
 
@@ -18,6 +18,8 @@
 #ifndef IGNITION_GUI_PLUGINS_SCENE3D_HH_
 #define IGNITION_GUI_PLUGINS_SCENE3D_HH_
 
+#include <atomic>
+#include <functional>
 #include <string>
 #include <memory>
 #include <mutex>
@@ -58,6 +60,33 @@ namespace plugins
   ///                          (0.3, 0.3, 0.3, 1.0)
   /// * \<camera_pose\> : Optional starting pose for the camera, defaults to
   ///                     (0, 0, 5, 0, 0, 0)
+  /// * \<render_on_demand\> : Optional, only render frames when the scene,
+  ///                          the view or the window size changed. Defaults
+  ///                          to false.
+  /// * \<max_idle_interval\> : Optional longest time in seconds between two
+  ///                           frames when rendering on demand, so changes
+  ///                           made by other plugins are shown. Defaults to
+  ///                           1.0.
+  /// * \<max_frame_rate\> : Optional frame rate cap, also used as the frame
+  ///                        time budget of the adaptive resolution. Defaults
+  ///                        to 0, no cap.
+  /// * \<anti_aliasing\> : Optional MSAA level, defaults to 8.
+  /// * \<adaptive_resolution\> : Optional, lower the anti-aliasing and then
+  ///                             the render resolution when frames take
+  ///                             longer than the budget on the GPU, and
+  ///                             restore them when they're well within it.
+  ///                             The budget is the frame period of
+  ///                             \<max_frame_rate\>, or 60 Hz. Needs OpenGL
+  ///                             timer queries. Defaults to false.
+  /// * \<min_render_scale\> : Optional lowest render resolution relative to
+  ///                          the window size for the adaptive resolution,
+  ///                          in (0, 1]. Defaults to 0.5.
+  /// * \<stats_topic\> : Optional topic to publish rendering statistics on
+  ///                     once per second, as an ignition::msgs::Param: the
+  ///                     50th and 95th percentiles and max of the time taken
+  ///                     by each stage of the frames, and scene counters.
+  /// * \<show_stats\> : Optional, show the rendering statistics over the
+  ///                    view. Defaults to false.
   class Scene3D : public Plugin
   {
     Q_OBJECT
@@ -92,7 +121,9 @@ namespace plugins
     public: ~IgnRenderer();
 
     ///  \brief Main render function
-    public: void Render();
+    /// \return True if a frame was rendered, false if rendering on demand
+    /// and nothing changed since the last frame
+    public: bool Render();
 
     /// \brief Initialize the render engine
     public: void Initialize();
@@ -106,8 +137,38 @@ namespace plugins
     public: void NewMouseEvent(const common::MouseEvent &_e,
         const math::Vector2d &_drag = math::Vector2d::Zero);
 
+    /// \brief Time to wait before rendering the next frame, to stay under
+    /// the max frame rate
+    /// \return Delay in milliseconds, 0 to render now
+    public: int FrameDelay() const;
+
+    /// \brief Time to wait for a change before rendering the idle frame,
+    /// when rendering on demand
+    /// \return Delay in milliseconds, 0 to render now
+    public: int IdleDelay() const;
+
+    /// \brief Set the function called when the scene, the poses or the
+    /// mouse changed, to wake the render thread up. It is called from the
+    /// transport, loading and GUI threads, and must be set before
+    /// Initialize().
+    /// \param[in] _wake Function to call
+    public: void SetWakeCallback(const std::function<void()> &_wake);
+
     /// \brief Handle mouse event for view control
-    private: void HandleMouseEvent();
+    /// \return True if there was a mouse event to handle
+    private: bool HandleMouseEvent();
+
+    /// \brief Resize the render texture to the texture size scaled by the
+    /// render scale, and set the anti-aliasing level
+    private: void UpdateRenderTexture();
+
+    /// \brief Lower or restore the anti-aliasing and resolution depending
+    /// on the GPU time taken by the frames
+    /// \param[in] _frameTime GPU time taken by a recent frame, in seconds
+    private: void AdaptResolution(double _frameTime);
+
+    /// \brief Publish the statistics and update their text, once per second
+    private: void UpdateStats();
 
     /// \brief Retrieve the first point on a surface in the 3D scene hit by a
     /// ray cast from the given 2D screen coordinates.
@@ -137,9 +198,13 @@ namespace plugins
     /// \brief True if engine has been initialized;
     public: bool initialized = false;
 
-    /// \brief Render texture size
+    /// \brief Size of the item displaying the render texture
     public: QSize textureSize = QSize(1024, 1024);
 
+    /// \brief Size of the render texture, which is smaller than the item
+    /// when the adaptive resolution scales it down
+    public: QSize renderSize = QSize(1024, 1024);
+
     /// \brief Flag to indicate texture size has changed.
     public: bool textureDirty = false;
 
@@ -160,6 +225,38 @@ namespace plugins
     /// added
     public: std::string sceneTopic;
 
+    /// \brief True to only render frames when something changed
+    public: bool renderOnDemand = false;
+
+    /// \brief Longest time in seconds between two frames when rendering on
+    /// demand
+    public: double maxIdleInterval = 1.0;
+
+    /// \brief Max frame rate, 0 for no cap
+    public: double maxFrameRate = 0.0;
+
+    /// \brief Highest anti-aliasing level
+    public: unsigned int antiAliasing = 8u;
+
+    /// \brief True to adapt the anti-aliasing and resolution to the frame
+    /// time
+    public: bool adaptiveResolution = false;
+
+    /// \brief Lowest render scale of the adaptive resolution
+    public: double minRenderScale = 0.5;
+
+    /// \brief Topic to publish the statistics on, empty to not publish them
+    public: std::string statsTopic;
+
+    /// \brief True to format the statistics as text
+    public: bool showStats = false;
+
+    /// \brief Latest statistics text
+    public: QString statsText;
+
+    /// \brief True when the statistics text was updated
+    public: bool statsReady = false;
+
     /// \internal
     /// \brief Pointer to private data.
     private: std::unique_ptr<IgnRendererPrivate> dataPtr;
@@ -182,12 +279,24 @@ namespace plugins
     /// \brief Slot called to update render texture size
     public slots: void SizeChanged();
 
+    /// \brief Render the next frame if the thread is waiting for a change,
+    /// when rendering on demand
+    public slots: void Wake();
+
+    /// \brief Stop waiting and render the next frame
+    private: void Resume();
+
     /// \brief Signal to indicate that a frame has been rendered and ready
     /// to be displayed
     /// \param[in] _id GLuid of the opengl texture
     /// \param[in] _size Size of the texture
     signals: void TextureReady(int _id, const QSize &_size);
 
+    /// \brief Signal emitted once per second with the rendering statistics,
+    /// when they are shown
+    /// \param[in] _text Statistics text
+    signals: void StatsReady(const QString &_text);
+
     /// \brief Offscreen surface to render to
     public: QOffscreenSurface *surface = nullptr;
 
@@ -196,6 +305,24 @@ namespace plugins
 
     /// \brief Ign-rendering renderer
     public: IgnRenderer ignRenderer;
+
+    /// \brief Renders the idle frame when nothing changed for the max idle
+    /// interval
+    private: QTimer *idleTimer = nullptr;
+
+    /// \brief Renders the next frame once the max frame rate allows it
+    private: QTimer *frameTimer = nullptr;
+
+    /// \brief True once ShutDown() destroyed the context, so the frames
+    /// and wake-ups still queued are ignored
+    private: bool shutDown = false;
+
+    /// \brief True while waiting for a change before the next frame
+    private: bool waiting = false;
+
+    /// \brief True while a call to Wake() is queued, so the updates
+    /// received meanwhile don't queue more
+    private: std::atomic<bool> wakePending{false};
   };
 
 
@@ -204,6 +331,13 @@ namespace plugins
   {
     Q_OBJECT
 
+    /// \brief Rendering statistics text
+    Q_PROPERTY(
+      QString statsText
+      READ StatsText
+      NOTIFY StatsTextChanged
+    )
+
     /// \brief Constructor
     /// \param[in] _parent Parent item
     public: explicit RenderWindowItem(QQuickItem *_parent = nullptr);
@@ -254,6 +388,49 @@ namespace plugins
     /// \param[in] _topic Scene topic
     public: void SetSceneTopic(const std::string &_topic);
 
+    /// \brief Set whether to only render frames when the scene, the view or
+    /// the window size changed
+    /// \param[in] _onDemand True to render on demand
+    public: void SetRenderOnDemand(bool _onDemand);
+
+    /// \brief Set the longest time between two frames when rendering on
+    /// demand
+    /// \param[in] _interval Time in seconds
+    public: void SetMaxIdleInterval(double _interval);
+
+    /// \brief Set the max frame rate
+    /// \param[in] _rate Frames per second, 0 for no cap
+    public: void SetMaxFrameRate(double _rate);
+
+    /// \brief Set the highest anti-aliasing level
+    /// \param[in] _level MSAA level
+    public: void SetAntiAliasing(unsigned int _level);
+
+    /// \brief Set whether to lower the anti-aliasing and the resolution
+    /// when frames take too long
+    /// \param[in] _adaptive True to adapt the resolution
+    /// \param[in] _minScale Lowest resolution relative to the window size
+    public: void SetAdaptiveResolution(bool _adaptive, double _minScale);
+
+    /// \brief Set the topic to publish rendering statistics on
+    /// \param[in] _topic Statistics topic
+    public: void SetStatsTopic(const std::string &_topic);
+
+    /// \brief Set whether to update the statistics text
+    /// \param[in] _show True to show the statistics
+    public: void SetShowStats(bool _show);
+
+    /// \brief Get the rendering statistics text
+    /// \return Statistics text
+    public: Q_INVOKABLE QString StatsText() const;
+
+    /// \brief Notify that the statistics text changed
+    signals: void StatsTextChanged();
+
+    /// \brief Slot called with the statistics of the render thread
+    /// \param[in] _text Statistics text
+    public slots: void SetStatsText(const QString &_text);
+
     /// \brief Slot called when thread is ready to be started
     public Q_SLOTS: void Ready();
 
@@ -28,6 +28,10 @@ Rectangle {
    */
   property bool gammaCorrect: false
 
+  /**
+   * True to show the rendering statistics
+   */
+  property bool showStats: false
 
   RenderWindow {
     id: renderWindow
@@ -46,6 +50,29 @@ Rectangle {
       visible: gammaCorrect
   }
 
+  /*
+   * Rendering statistics overlay, enabled with <show_stats>
+   */
+  Rectangle {
+    visible: showStats
+    anchors.top: parent.top
+    anchors.left: parent.left
+    anchors.margins: 5
+    width: statsLabel.width + 10
+    height: statsLabel.height + 10
+    color: "#80000000"
+    radius: 3
+
+    Text {
+      id: statsLabel
+      anchors.centerIn: parent
+      text: renderWindow.statsText
+      color: "white"
+      font.family: "monospace"
+      font.pointSize: 9
+    }
+  }
+
   onParentChanged: {
     if (undefined === parent)
       return;
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_GUI_PLUGINS_SCENECONTENTS_HH_
+#define IGNITION_GUI_PLUGINS_SCENECONTENTS_HH_
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <ignition/msgs/light.pb.h>
+#include <ignition/msgs/model.pb.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "EntityMap.hh"
+
+namespace ignition
+{
+namespace gui
+{
+namespace plugins
+{
+  /// \brief Clear the poses of a light msg
+  /// \param[in, out] _msg Light msg
+  inline void ClearPoses(msgs::Light &_msg)
+  {
+    _msg.clear_pose();
+  }
+
+  /// \brief Clear the poses of a model msg and of all its links, visuals,
+  /// collisions, lights and nested models
+  /// \param[in, out] _msg Model msg
+  inline void ClearPoses(msgs::Model &_msg)
+  {
+    _msg.clear_pose();
+    for (auto &link : *_msg.mutable_link())
+    {
+      link.clear_pose();
+      for (auto &visual : *link.mutable_visual())
+        visual.clear_pose();
+      for (auto &collision : *link.mutable_collision())
+      {
+        collision.clear_pose();
+        for (auto &visual : *collision.mutable_visual())
+          visual.clear_pose();
+      }
+      for (auto &light : *link.mutable_light())
+        ClearPoses(light);
+    }
+    for (auto &model : *_msg.mutable_model())
+      ClearPoses(model);
+  }
+
+  /// \brief Hash of the content of a model or light msg, leaving out the
+  /// poses, which are updated by the pose msgs and change with every
+  /// republish
+  /// \param[in] _msg Model or light msg
+  /// \return Hash of the msg
+  template<typename T>
+  std::size_t ContentHash(const T &_msg)
+  {
+    T content(_msg);
+    ClearPoses(content);
+    return std::hash<std::string>()(content.SerializeAsString());
+  }
+
+  /// \brief How an entity of a scene msg compares to the loaded one
+  enum class ContentChange
+  {
+    /// \brief The entity isn't loaded
+    NEW,
+
+    /// \brief The entity is loaded with the same content, so a republished
+    /// scene msg doesn't recreate it
+    UNCHANGED,
+
+    /// \brief The entity is loaded with a different content, so it's
+    /// replaced
+    CHANGED
+  };
+
+  /// \brief Content hashes of the loaded models and lights, so scene msgs
+  /// are applied as a diff against them
+  class SceneContents
+  {
+    /// \brief Compare an entity of a scene msg to the loaded one
+    /// \param[in] _id Entity id
+    /// \param[in] _hash Content hash of the entity, see ContentHash()
+    /// \return How the entity changed
+    public: ContentChange Compare(const unsigned int _id,
+                                  const std::size_t _hash)
+    {
+      auto content = this->hashes.Find(_id);
+      if (!content)
+        return ContentChange::NEW;
+      return *content == _hash ? ContentChange::UNCHANGED :
+                                 ContentChange::CHANGED;
+    }
+
+    /// \brief Set the content hash of a loaded entity
+    /// \param[in] _id Entity id
+    /// \param[in] _hash Content hash of the entity
+    public: void Set(const unsigned int _id, const std::size_t _hash)
+    {
+      this->hashes[_id] = _hash;
+    }
+
+    /// \brief Forget an entity, e.g. when it's deleted or failed to load,
+    /// so it's loaded again when it's republished
+    /// \param[in] _id Entity id
+    public: void Erase(const unsigned int _id)
+    {
+      this->hashes.Erase(_id);
+    }
+
+    /// \brief Content hash per entity id
+    private: EntityMap<std::size_t> hashes;
+  };
+}
+}
+}
+
+#endif
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include "SceneContents.hh"
+
+using namespace ignition;
+using namespace gui;
+using namespace plugins;
+
+/////////////////////////////////////////////////
+/// \brief Set the x of a pose msg
+void SetX(msgs::Pose *_pose, double _x)
+{
+  _pose->mutable_position()->set_x(_x);
+  _pose->mutable_orientation()->set_w(1.0);
+}
+
+/////////////////////////////////////////////////
+/// \brief Model with a link holding a visual, a collision and a light, and
+/// a nested model, all at x
+msgs::Model MakeModel(double _x)
+{
+  msgs::Model model;
+  model.set_id(1);
+  model.set_name("model");
+  SetX(model.mutable_pose(), _x);
+
+  auto link = model.add_link();
+  link->set_id(2);
+  link->set_name("link");
+  SetX(link->mutable_pose(), _x);
+
+  auto visual = link->add_visual();
+  visual->set_id(3);
+  visual->set_name("visual");
+  SetX(visual->mutable_pose(), _x);
+  visual->mutable_geometry()->mutable_box()->mutable_size()->set_x(1.0);
+
+  auto collision = link->add_collision();
+  collision->set_id(4);
+  collision->set_name("collision");
+  SetX(collision->mutable_pose(), _x);
+  SetX(collision->add_visual()->mutable_pose(), _x);
+
+  auto light = link->add_light();
+  light->set_id(5);
+  light->set_name("light");
+  SetX(light->mutable_pose(), _x);
+
+  auto nested = model.add_model();
+  nested->set_id(6);
+  nested->set_name("nested");
+  SetX(nested->mutable_pose(), _x);
+  SetX(nested->add_link()->mutable_pose(), _x);
+  return model;
+}
+
+/////////////////////////////////////////////////
+TEST(SceneContentsTest, ContentHash)
+{
+  auto model = MakeModel(1.0);
+  auto hash = ContentHash(model);
+
+  // poses change with every republish, they don't count
+  EXPECT_EQ(hash, ContentHash(MakeModel(2.0)));
+
+  // the msg itself is left as it is
+  EXPECT_DOUBLE_EQ(1.0, model.pose().position().x());
+  EXPECT_DOUBLE_EQ(1.0, model.link(0).visual(0).pose().position().x());
+
+  // any other change does, including in nested entities
+  auto changed = model;
+  changed.set_name("other");
+  EXPECT_NE(hash, ContentHash(changed));
+
+  changed = model;
+  changed.mutable_link(0)->mutable_visual(0)->mutable_geometry()->
+      mutable_box()->mutable_size()->set_x(2.0);
+  EXPECT_NE(hash, ContentHash(changed));
+
+  changed = model;
+  changed.mutable_model(0)->mutable_link(0)->set_name("other");
+  EXPECT_NE(hash, ContentHash(changed));
+
+  msgs::Light light;
+  light.set_id(7);
+  light.set_range(10.0);
+  SetX(light.mutable_pose(), 1.0);
+  auto lightHash = ContentHash(light);
+
+  auto movedLight = light;
+  SetX(movedLight.mutable_pose(), 2.0);
+  EXPECT_EQ(lightHash, ContentHash(movedLight));
+
+  auto changedLight = light;
+  changedLight.set_range(20.0);
+  EXPECT_NE(lightHash, ContentHash(changedLight));
+}
+
+/////////////////////////////////////////////////
+TEST(SceneContentsTest, Republish)
+{
+  SceneContents contents;
+  auto hash = ContentHash(MakeModel(1.0));
+  EXPECT_EQ(ContentChange::NEW, contents.Compare(1, hash));
+  contents.Set(1, hash);
+
+  // an identical republish, with the entities moved, is skipped
+  EXPECT_EQ(ContentChange::UNCHANGED,
+      contents.Compare(1, ContentHash(MakeModel(2.0))));
+
+  // a model which changed is replaced
+  auto changed = MakeModel(2.0);
+  changed.mutable_link(0)->mutable_visual(0)->mutable_geometry()->
+      mutable_box()->mutable_size()->set_x(2.0);
+  auto changedHash = ContentHash(changed);
+  EXPECT_EQ(ContentChange::CHANGED, contents.Compare(1, changedHash));
+  contents.Set(1, changedHash);
+  EXPECT_EQ(ContentChange::UNCHANGED, contents.Compare(1, changedHash));
+  EXPECT_EQ(ContentChange::CHANGED, contents.Compare(1, hash));
+
+  // other entities aren't affected
+  EXPECT_EQ(ContentChange::NEW, contents.Compare(2, changedHash));
+
+  // a deleted model, or one which failed to load, is loaded again
+  contents.Erase(1);
+  EXPECT_EQ(ContentChange::NEW, contents.Compare(1, changedHash));
+}
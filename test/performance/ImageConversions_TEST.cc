@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+
+#include <QImage>
+
+#include "ImageConversions.hh"
+
+using namespace ignition;
+using namespace gui;
+using namespace plugins;
+
+/// \brief Image width in pixels
+static const unsigned int kWidth = 1920;
+
+/// \brief Image height in pixels
+static const unsigned int kHeight = 1080;
+
+/// \brief Number of conversions timed
+static const int kIterations = 20;
+
+/// \brief Average time of a conversion
+/// \param[in] _convert Conversion
+/// \return Milliseconds per conversion
+static double TimeMs(const std::function<void()> &_convert)
+{
+  // Warm up
+  _convert();
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i)
+    _convert();
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / kIterations;
+}
+
+/// \brief Check that the gray values of two images are within one level
+/// \param[in] _expected Image converted pixel by pixel
+/// \param[in] _actual Gray image converted by the kernels
+static void ExpectNear(const QImage &_expected, const QImage &_actual)
+{
+  ASSERT_EQ(_expected.size(), _actual.size());
+  for (int j = 0; j < _expected.height(); ++j)
+  {
+    const uchar *line = _actual.constScanLine(j);
+    for (int i = 0; i < _expected.width(); ++i)
+    {
+      int expected = qRed(_expected.pixel(i, j));
+      ASSERT_LE(std::abs(expected - line[i]), 1)
+          << "pixel [" << i << ", " << j << "]";
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(ImageConversionsTest, Float32)
+{
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<float> dist(0.1f, 10.0f);
+  std::string data(kWidth * kHeight * sizeof(float), '\0');
+  for (unsigned int i = 0; i < kWidth * kHeight; ++i)
+  {
+    float d = (i % 97 == 0) ? std::numeric_limits<float>::infinity() :
+        dist(gen);
+    std::memcpy(&data[i * sizeof(float)], &d, sizeof(d));
+  }
+
+  // Implementation before the kernels
+  QImage expected;
+  auto pixelByPixel = [&]()
+  {
+    expected = QImage(kWidth, kHeight, QImage::Format_RGB888);
+    float *depthBuffer = new float[kWidth * kHeight];
+    std::memcpy(depthBuffer, data.data(), data.size());
+    float maxDepth = 0;
+    for (unsigned int i = 0; i < kWidth * kHeight; ++i)
+    {
+      if (depthBuffer[i] > maxDepth && !std::isinf(depthBuffer[i]))
+        maxDepth = depthBuffer[i];
+    }
+    double factor = 255 / maxDepth;
+    for (unsigned int j = 0; j < kHeight; ++j)
+    {
+      for (unsigned int i = 0; i < kWidth; ++i)
+      {
+        float d = depthBuffer[j * kWidth + i];
+        d = 255 - (d * factor);
+        auto value = static_cast<int>(std::max(0.0f, std::min(255.0f, d)));
+        expected.setPixel(i, j, qRgb(value, value, value));
+      }
+    }
+    delete [] depthBuffer;
+  };
+
+  QImage actual(kWidth, kHeight, QImage::Format_Grayscale8);
+  auto kernels = [&]()
+  {
+    auto bytes = reinterpret_cast<const unsigned char *>(data.data());
+    auto step = kWidth * sizeof(float);
+    float minDepth = std::numeric_limits<float>::max();
+    float maxDepth = 0;
+    for (unsigned int j = 0; j < kHeight; ++j)
+      conversions::MinMax(bytes + j * step, kWidth, minDepth, maxDepth);
+    float factor = 255 / maxDepth;
+    for (unsigned int j = 0; j < kHeight; ++j)
+    {
+      conversions::DepthToGray8(bytes + j * step, kWidth, factor,
+          actual.scanLine(j));
+    }
+  };
+
+  double before = TimeMs(pixelByPixel);
+  double after = TimeMs(kernels);
+  std::cout << "R_FLOAT32 " << kWidth << "x" << kHeight
+            << ": pixel by pixel " << before << " ms, kernels " << after
+            << " ms" << std::endl;
+
+  ExpectNear(expected, actual);
+}
+
+/////////////////////////////////////////////////
+TEST(ImageConversionsTest, LInt16)
+{
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<uint16_t> dist(2000, 40000);
+  std::string data(kWidth * kHeight * sizeof(uint16_t), '\0');
+  for (unsigned int i = 0; i < kWidth * kHeight; ++i)
+  {
+    uint16_t t = dist(gen);
+    std::memcpy(&data[i * sizeof(uint16_t)], &t, sizeof(t));
+  }
+
+  // Implementation before the kernels
+  QImage expected;
+  auto pixelByPixel = [&]()
+  {
+    expected = QImage(kWidth, kHeight, QImage::Format_RGB888);
+    uint16_t *buffer = new uint16_t[kWidth * kHeight];
+    std::memcpy(buffer, data.data(), data.size());
+    uint16_t min = std::numeric_limits<uint16_t>::max();
+    uint16_t max = 0;
+    for (unsigned int i = 0; i < kWidth * kHeight; ++i)
+    {
+      if (buffer[i] > max)
+        max = buffer[i];
+      if (buffer[i] < min)
+        min = buffer[i];
+    }
+    double range = static_cast<double>(max - min);
+    if (range == 0.0)
+      range = 1.0;
+    for (unsigned int j = 0; j < kHeight; ++j)
+    {
+      for (unsigned int i = 0; i < kWidth; ++i)
+      {
+        double t = static_cast<double>(buffer[j * kWidth + i] - min) / range;
+        int value = static_cast<int>(255 * t);
+        expected.setPixel(i, j, qRgb(value, value, value));
+      }
+    }
+    delete [] buffer;
+  };
+
+  QImage actual(kWidth, kHeight, QImage::Format_Grayscale8);
+  auto kernels = [&]()
+  {
+    auto bytes = reinterpret_cast<const unsigned char *>(data.data());
+    auto step = kWidth * sizeof(uint16_t);
+    uint16_t min = std::numeric_limits<uint16_t>::max();
+    uint16_t max = 0;
+    for (unsigned int j = 0; j < kHeight; ++j)
+      conversions::MinMax(bytes + j * step, kWidth, min, max);
+    float range = std::max(1.0f, static_cast<float>(max - min));
+    for (unsigned int j = 0; j < kHeight; ++j)
+    {
+      conversions::ScaleToGray8(bytes + j * step, kWidth, min, 255 / range,
+          actual.scanLine(j));
+    }
+  };
+
+  double before = TimeMs(pixelByPixel);
+  double after = TimeMs(kernels);
+  std::cout << "L_INT16 " << kWidth << "x" << kHeight
+            << ": pixel by pixel " << before << " ms, kernels " << after
+            << " ms" << std::endl;
+
+  ExpectNear(expected, actual);
+}